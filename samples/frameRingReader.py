@@ -0,0 +1,148 @@
+#!/usr/bin/env python3
+
+## reads frames from a frame ring created by ospNewFrameRing, in
+## another process; doesn't need ospray (or these bindings) at all:
+##
+##   from frameRingReader import FrameRingReader
+##   ring = FrameRingReader("viewer")
+##   frameId = ring.wait()                ## next frame
+##   pixels = ring.view(frameId)          ## zero-copy (height,width,4)
+##   ...encode pixels...
+##   if not ring.intact(frameId) : ...    ## got overwritten meanwhile
+##
+## or from the command line, to watch a ring:
+##
+##   ./frameRingReader.py viewer --frames 100
+
+import argparse
+import collections
+import mmap
+import os
+import struct
+import sys
+import time
+import zlib
+
+MAGIC       = b"OSPRING\0"
+VERSION     = 1
+HEADER      = struct.Struct("=8sIIQQQiiIIQ")   ## FrameRingHeader
+SLOT        = struct.Struct("=QQQiiIIQ")       ## FrameSlotHeader
+PUBLISHED   = struct.Struct("=Q")
+PUBLISHED_AT = HEADER.size - PUBLISHED.size
+
+Frame = collections.namedtuple("Frame", "frameId timestamp width height pixels")
+
+class FrameRingReader :
+    def __init__(self, name) :
+        name = name.lstrip("/")
+        try :
+            fd = os.open(os.path.join("/dev/shm", name), os.O_RDONLY)
+            try :
+                self.memory = mmap.mmap(fd, 0, prot=mmap.PROT_READ)
+            finally :
+                os.close(fd)
+            self.shm = None
+        except FileNotFoundError :
+            ## no /dev/shm (e.g., macOS)
+            from multiprocessing import shared_memory, resource_tracker
+            self.shm = shared_memory.SharedMemory(name)
+            ## we only read; the creator unlinks it
+            resource_tracker.unregister(self.shm._name, "shared_memory")
+            self.memory = self.shm.buf
+        (magic, version, self.numSlots, self.slotBytes, self.firstSlot,
+         self.pixelOffset, self.width, self.height, self.format,
+         self.bytesPerPixel, published) = HEADER.unpack_from(self.memory, 0)
+        if magic != MAGIC or version != VERSION :
+            raise ValueError("'%s' is not a frame ring (version %d)" % (name, VERSION))
+        self.data = memoryview(self.memory)
+
+    def close(self) :
+        self.data.release()
+        if self.shm :
+            self.shm.close()
+        else :
+            self.memory.close()
+
+    def __enter__(self) :
+        return self
+
+    def __exit__(self, *args) :
+        self.close()
+
+    def published(self) :
+        ## number of frames published so far; the latest is published-1
+        return PUBLISHED.unpack_from(self.memory, PUBLISHED_AT)[0]
+
+    def slotOffset(self, frameId) :
+        return self.firstSlot + (frameId % self.numSlots) * self.slotBytes
+
+    def sequence(self, frameId) :
+        return PUBLISHED.unpack_from(self.memory, self.slotOffset(frameId))[0]
+
+    def intact(self, frameId) :
+        ## whether frame 'frameId' is (still) complete in its slot
+        return self.sequence(frameId) == 2 * frameId + 2
+
+    def wait(self, after=-1, timeout=None, poll=0.001) :
+        ## waits for a frame newer than 'after'; returns the latest
+        ## frame id, or None on timeout
+        deadline = None if timeout is None else time.monotonic() + timeout
+        while True :
+            published = self.published()
+            if published and published - 1 > after :
+                return published - 1
+            if deadline is not None and time.monotonic() >= deadline :
+                return None
+            time.sleep(poll)
+
+    def view(self, frameId) :
+        ## the frame's pixels in place, shaped (height, width, 4); only
+        ## valid while intact(frameId)
+        begin = self.slotOffset(frameId) + self.pixelOffset
+        pixels = self.data[begin : begin + self.width * self.height * self.bytesPerPixel]
+        return pixels.cast("B" if self.bytesPerPixel == 4 else "f",
+                           [ self.height, self.width, 4 ])
+
+    def read(self, frameId=None) :
+        ## a copy of frame 'frameId' (default: the latest), or None if
+        ## it isn't in the ring (anymore)
+        if frameId is None :
+            frameId = self.published() - 1
+            if frameId < 0 :
+                return None
+        if not self.intact(frameId) :
+            return None
+        sequence, _, timestamp, width, height, _, _, pixelBytes \
+            = SLOT.unpack_from(self.memory, self.slotOffset(frameId))
+        begin = self.slotOffset(frameId) + self.pixelOffset
+        pixels = bytes(self.data[begin : begin + pixelBytes])
+        if not self.intact(frameId) :
+            return None
+        return Frame(frameId, timestamp, width, height, pixels)
+
+def main() :
+    parser = argparse.ArgumentParser(description="watch the frames of an ospray frame ring")
+    parser.add_argument("name", help="shared memory name passed to ospNewFrameRing")
+    parser.add_argument("--frames", type=int, default=10, help="number of frames to read")
+    parser.add_argument("--timeout", type=float, default=10, help="seconds to wait per frame")
+    args = parser.parse_args()
+
+    with FrameRingReader(args.name) as ring :
+        print("%s: %dx%d, %d bytes/pixel, %d slots"
+              % (args.name, ring.width, ring.height, ring.bytesPerPixel, ring.numSlots))
+        frameId = -1
+        for i in range(args.frames) :
+            frameId = ring.wait(frameId, args.timeout)
+            if frameId is None :
+                print("timed out")
+                return 1
+            frame = ring.read(frameId)
+            if frame is None :
+                print("frame %d: overwritten while reading" % frameId)
+                continue
+            print("frame %d: t=%.6fs crc32=%08x"
+                  % (frame.frameId, frame.timestamp * 1e-9, zlib.crc32(frame.pixels)))
+    return 0
+
+if __name__ == "__main__" :
+    sys.exit(main())
@@ -0,0 +1,279 @@
+#!/usr/bin/env python3
+
+## benchmark suite for the bindings, to catch performance regressions:
+##
+##  - calls:   per-call latency of the setters and of ospRenderFrame on
+##             a tiny scene
+##  - data:    ospNewData throughput (elements/s), list vs. buffer input
+##  - save:    ospFrameBufferSave throughput (MB/s of pixels), PNG and
+##             PPM at 1080p, 4K and 8K
+##  - writers: the same PNG/PPM writers through ospSaveImage, which
+##             doesn't need an ospray device or frame buffer at all
+##  - rss:     peak resident memory while uploading large arrays (each
+##             case runs in a fresh process)
+##
+## usage:
+##
+##   ./ospBenchmark.py --json baseline.json       ## save a baseline
+##   ./ospBenchmark.py --compare baseline.json    ## check against it
+##   ./ospBenchmark.py --sections writers         ## no ospray device
+##
+## --compare exits with status 1 if any result is worse than the
+## baseline by more than --tolerance (default 10%); for the rss results
+## it takes at least RSS_FLOOR_MB more, since the upload of a shared
+## buffer is close to 0 MB and a few pages of noise would be "10%"
+
+import argparse
+import array
+import json
+import os
+import platform
+import resource
+import subprocess
+import sys
+import tempfile
+import time
+import ospray
+from ospray import *
+
+ALL_SECTIONS = [ "calls", "data", "save", "writers", "rss" ]
+
+IMAGE_SIZES = [ ("1080p", 1920, 1080), ("4K", 3840, 2160), ("8K", 7680, 4320) ]
+DATA_SIZES  = [ 1000, 100000, 1000000 ]
+RSS_SIZE    = 4000000
+RSS_FLOOR_MB = 1.0
+
+results = {}
+
+def record(name, value, unit, higherIsBetter) :
+    results[name] = { "value" : value, "unit" : unit,
+                      "higher_is_better" : higherIsBetter }
+    print("%-36s %14.6g %s" % (name, value, unit))
+    sys.stdout.flush()
+
+def secondsPerCall(call, minSeconds=0.2, repeats=3) :
+    ## best of 'repeats' runs of at least minSeconds each; the best run
+    ## is the one least disturbed by everything else on the machine
+    call()
+    best = float("inf")
+    for r in range(repeats) :
+        numCalls = 0
+        begin = time.perf_counter()
+        while True :
+            call()
+            numCalls += 1
+            seconds = time.perf_counter() - begin
+            if seconds >= minSeconds :
+                break
+        best = min(best, seconds / numCalls)
+    return best
+
+def tinyScene() :
+    camera = ospNewCamera("perspective")
+    ospSet3fv(camera, "pos", [0, 0, 0])
+    ospSet3fv(camera, "dir", [0, 0, 1])
+    ospSet3fv(camera, "up",  [0, 1, 0])
+    ospCommit(camera)
+
+    mesh = ospNewGeometry("triangles")
+    vertex = ospNewData(3, "float3", [ -1, -1, 3,  1, -1, 3,  0, 1, 3 ])
+    index  = ospNewData(1, "int3", [ 0, 1, 2 ])
+    ospCommit(vertex)
+    ospCommit(index)
+    ospSetData(mesh, "vertex", vertex)
+    ospSetData(mesh, "index", index)
+    ospCommit(mesh)
+
+    model = ospNewModel()
+    ospAddGeometry(model, mesh)
+    ospCommit(model)
+
+    renderer = ospNewRenderer("scivis")
+    ospSetObject(renderer, "model", model)
+    ospSetObject(renderer, "camera", camera)
+    ospCommit(renderer)
+    return camera, renderer
+
+def benchCalls() :
+    camera, renderer = tinyScene()
+    framebuffer = ospNewFrameBuffer([16,16], "srgba", [ "color" ])
+    pos = [0.0, 0.0, 0.0]
+    calls = [
+        ("ospSet1f",       lambda : ospSet1f(camera, "fovy", 60.0)),
+        ("ospSet1i",       lambda : ospSet1i(renderer, "spp", 1)),
+        ("ospSet3f",       lambda : ospSet3f(camera, "pos", 0.0, 0.0, 0.0)),
+        ("ospSet3fv",      lambda : ospSet3fv(camera, "pos", pos)),
+        ("ospSetObject",   lambda : ospSetObject(renderer, "camera", camera)),
+        ("ospCommit",      lambda : ospCommit(camera)),
+        ("ospRenderFrame", lambda : ospRenderFrame(framebuffer, renderer, ["color"])),
+    ]
+    for name, call in calls :
+        record("calls/%s" % name, secondsPerCall(call) * 1e9, "ns/call", False)
+    ospRelease(framebuffer)
+
+def benchData() :
+    for numItems in DATA_SIZES :
+        values = [ float(i % 1000) for i in range(3 * numItems) ]
+        inputs = [ ("list", values), ("buffer", array.array("f", values)) ]
+        for kind, items in inputs :
+            def upload() :
+                data = ospNewData(numItems, "float3", items)
+                ospCommit(data)
+                ospRelease(data)
+            seconds = secondsPerCall(upload, minSeconds=0.1)
+            record("data/%s/%d" % (kind, numItems), numItems / seconds,
+                   "elements/s", True)
+
+def testImage(width, height) :
+    ## smooth but not constant content, so PNG's filters and deflate
+    ## have about as much to do as on a rendered image
+    row = bytes((x * 255 // width) for x in range(width)) * 4
+    rows = [ row.translate(bytes(((v + k) & 255) for v in range(256)))
+             for k in range(0, 256, 3) ]
+    pixels = bytearray(b"".join(rows[y % len(rows)] for y in range(height)))
+    return memoryview(pixels).cast("B", [ height, width, 4 ])
+
+def benchSave(directory) :
+    camera, renderer = tinyScene()
+    for sizeName, width, height in IMAGE_SIZES :
+        ospSetf(camera, "aspect", width / height)
+        ospCommit(camera)
+        framebuffer = ospNewFrameBuffer([width, height], "srgba", [ "color" ])
+        ospRenderFrame(framebuffer, renderer, ["color"])
+        for ext in [ "png", "ppm" ] :
+            fileName = os.path.join(directory, "save." + ext)
+            seconds = secondsPerCall(lambda : ospFrameBufferSave(fileName, framebuffer,
+                                                                 [width, height], "srgba"),
+                                     minSeconds=0.5)
+            record("save/%s/%s" % (ext, sizeName), width * height * 4 / seconds / 1e6,
+                   "MB/s", True)
+        ospRelease(framebuffer)
+
+def benchWriters(directory) :
+    for sizeName, width, height in IMAGE_SIZES :
+        pixels = testImage(width, height)
+        for ext in [ "png", "ppm" ] :
+            fileName = os.path.join(directory, "writer." + ext)
+            seconds = secondsPerCall(lambda : ospSaveImage(fileName, pixels),
+                                     minSeconds=0.5)
+            record("writers/%s/%s" % (ext, sizeName), width * height * 4 / seconds / 1e6,
+                   "MB/s", True)
+
+def resetPeakRSS() :
+    ## linux (>= 4.0) resets the peak to the current RSS on this; else
+    ## the peak also covers building the input
+    try :
+        with open("/proc/self/clear_refs", "w") as f :
+            f.write("5")
+    except OSError :
+        pass
+
+def peakRSS() :
+    try :
+        with open("/proc/self/status") as f :
+            for line in f :
+                if line.startswith("VmHWM:") :
+                    return int(line.split()[1]) * 1024
+    except OSError :
+        pass
+    ## ru_maxrss is in kilobytes on linux
+    return resource.getrusage(resource.RUSAGE_SELF).ru_maxrss * 1024
+
+def rssCase(kind, numItems) :
+    ## runs in its own process (see benchRSS), so the peak is this case's
+    ospray.ospInit()
+    values = ( float(i % 1000) for i in range(3 * numItems) )
+    values = array.array("f", values) if kind == "buffer" else list(values)
+    resetPeakRSS()
+    before = peakRSS()
+    data = ospNewData(numItems, "float3", values)
+    ospCommit(data)
+    after = peakRSS()
+    ospRelease(data)
+    print(json.dumps({ "before" : before, "after" : after }))
+
+def benchRSS() :
+    for kind in [ "list", "buffer" ] :
+        output = subprocess.check_output([ sys.executable, os.path.abspath(__file__),
+                                           "--rss-case", kind, str(RSS_SIZE) ])
+        rss = json.loads(output.decode().strip().splitlines()[-1])
+        record("rss/%s/%d/peak" % (kind, RSS_SIZE), rss["after"] / 1e6, "MB", False)
+        record("rss/%s/%d/upload" % (kind, RSS_SIZE),
+               (rss["after"] - rss["before"]) / 1e6, "MB", False)
+
+def compare(baselineFile, tolerance) :
+    with open(baselineFile) as f :
+        baseline = json.load(f)["results"]
+    regressions = 0
+    print("\n%-36s %14s %14s %8s" % ("", "baseline", "now", "ratio"))
+    for name, now in sorted(results.items()) :
+        if name not in baseline :
+            continue
+        old = baseline[name]["value"]
+        new = now["value"]
+        ratio = new / old if old else float("inf")
+        slack = abs(old) * tolerance
+        if now["unit"] == "MB" :
+            slack = max(slack, RSS_FLOOR_MB)
+        if now["higher_is_better"] :
+            worse = new < old - slack
+        else :
+            worse = new > old + slack
+        regressions += worse
+        print("%-36s %14.6g %14.6g %7.2fx%s" % (name, old, new, ratio,
+                                                "  REGRESSION" if worse else ""))
+    print("\n%d regression(s) beyond %.0f%% (and at least %g MB for rss)"
+          % (regressions, tolerance * 100, RSS_FLOOR_MB))
+    return regressions
+
+def main() :
+    parser = argparse.ArgumentParser(description="benchmarks for the ospray python bindings")
+    parser.add_argument("--sections", default=",".join(ALL_SECTIONS),
+                        help="comma separated subset of: " + ", ".join(ALL_SECTIONS))
+    parser.add_argument("--json", help="write the results to this file")
+    parser.add_argument("--compare", help="compare the results against this baseline file")
+    parser.add_argument("--tolerance", type=float, default=0.1,
+                        help="relative change that counts as a regression (default 0.1)")
+    parser.add_argument("--rss-case", nargs=2, help=argparse.SUPPRESS)
+    args = parser.parse_args()
+
+    if args.rss_case :
+        rssCase(args.rss_case[0], int(args.rss_case[1]))
+        return 0
+
+    sections = [ s for s in args.sections.split(",") if s ]
+    for s in sections :
+        if s not in ALL_SECTIONS :
+            parser.error("unknown section '%s'" % s)
+
+    ## everything but the writers needs an ospray device
+    if [ s for s in sections if s not in [ "writers", "rss" ] ] :
+        ospray.ospInit()
+
+    with tempfile.TemporaryDirectory() as directory :
+        for s in sections :
+            if s == "calls" :
+                benchCalls()
+            elif s == "data" :
+                benchData()
+            elif s == "save" :
+                benchSave(directory)
+            elif s == "writers" :
+                benchWriters(directory)
+            elif s == "rss" :
+                benchRSS()
+
+    if args.json :
+        meta = {
+            "python"   : platform.python_version(),
+            "platform" : platform.platform(),
+            "cpus"     : os.cpu_count(),
+            "time"     : time.strftime("%Y-%m-%d %H:%M:%S"),
+        }
+        with open(args.json, "w") as f :
+            json.dump({ "meta" : meta, "results" : results }, f, indent=2, sort_keys=True)
+    if args.compare :
+        return 1 if compare(args.compare, args.tolerance) else 0
+    return 0
+
+sys.exit(main())
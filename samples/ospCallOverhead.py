@@ -0,0 +1,42 @@
+#!/usr/bin/env python3
+
+## measures how many calls per second the bindings manage for the
+## small per-frame calls (camera updates, animated parameters, and
+## rendering into a tiny frame buffer), i.e. mostly the overhead of
+## getting from python into ospray and back
+
+import time
+import ospray
+from ospray import *
+
+def callsPerSecond(name, call, numCalls=200000) :
+    call()
+    begin = time.perf_counter()
+    for i in range(numCalls) :
+        call()
+    seconds = time.perf_counter() - begin
+    print("%-16s %12.0f calls/s" % (name, numCalls / seconds))
+
+def main() :
+    ospray.ospInit()
+
+    camera = ospNewCamera("perspective")
+    pos = [0.0, 0.0, 0.0]
+    renderer = ospNewRenderer("scivis")
+    ospCommit(renderer)
+    framebuffer = ospNewFrameBuffer([1,1], "srgba", [ "color" ])
+
+    callsPerSecond("ospSet1f",       lambda : ospSet1f(camera, "fovy", 60.0))
+    callsPerSecond("ospSet1i",       lambda : ospSet1i(renderer, "spp", 1))
+    callsPerSecond("ospSet3fv",      lambda : ospSet3fv(camera, "pos", pos))
+    callsPerSecond("ospSetObject",   lambda : ospSetObject(renderer, "camera", camera))
+    callsPerSecond("ospCommit",      lambda : ospCommit(camera))
+    callsPerSecond("ospRenderFrame", lambda : ospRenderFrame(framebuffer, renderer, ["color"]),
+                   numCalls=20000)
+
+    ospRelease(framebuffer)
+    ospRelease(renderer)
+    ospRelease(camera)
+    ospShutdown()
+
+main()
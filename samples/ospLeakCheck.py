@@ -0,0 +1,134 @@
+#!/usr/bin/env python3
+
+## leak regression check for the conversion of python lists (and
+## tuples) into data arrays, parameters and channel masks: runs each
+## case many times, and fails if that changes the refcount of any of
+## its inputs, or keeps growing the resident memory of the process
+##
+## usage:
+##
+##   ./ospLeakCheck.py                            ## all cases
+##   ./ospLeakCheck.py --iterations 200000        ## more calls per case
+##   ./ospLeakCheck.py --cases data/floats,renderFrame
+##
+## exits with status 1 if any case leaks
+
+import argparse
+import resource
+import sys
+import ospray
+from ospray import *
+
+def residentBytes() :
+    ## the current RSS where /proc has it; else the peak, which can't
+    ## stay flat either if every call leaks
+    try :
+        with open("/proc/self/status") as f :
+            for line in f :
+                if line.startswith("VmRSS:") :
+                    return int(line.split()[1]) * 1024
+    except OSError :
+        pass
+    ## ru_maxrss is in kilobytes on linux
+    return resource.getrusage(resource.RUSAGE_SELF).ru_maxrss * 1024
+
+def makeCases() :
+    ## (name, call, inputs whose refcounts have to stay the same); the
+    ## values aren't small ints, which python shares and caches
+    camera = ospNewCamera("perspective")
+    renderer = ospNewRenderer("scivis")
+    ospCommit(renderer)
+    light = ospNewLight("ambient")
+    framebuffer = ospNewFrameBuffer([4,4], "srgba", [ "color", "accum" ])
+
+    floats = [ 0.5 + i for i in range(3000) ]
+    ints = [ 1000 + i for i in range(3000) ]
+    floatTuple = tuple(floats)
+    lights = [ light ]
+    vector = [ 0.5, 1.5, 2.5 ]
+    intVector = [ 1000, 1001, 1002 ]
+    channels = [ "color", "accum" ]
+    badChannels = [ "color", "bogus" ]
+
+    def newData(numItems, format, values) :
+        ospRelease(ospNewData(numItems, format, values))
+
+    def renderBadChannels() :
+        try :
+            ospRenderFrame(framebuffer, renderer, badChannels)
+        except TypeError :
+            pass
+
+    return [
+        ("data/floats",      lambda : newData(1000, "float3", floats),
+                             [ floats, floats[0], floats[-1] ]),
+        ("data/ints",        lambda : newData(1000, "int3", ints),
+                             [ ints, ints[0], ints[-1] ]),
+        ("data/tuple",       lambda : newData(1000, "float3", floatTuple),
+                             [ floatTuple, floatTuple[0] ]),
+        ("data/objects",     lambda : newData(1, "OSP_LIGHT", lights),
+                             [ lights ]),
+        ("ospSet3fv",        lambda : ospSet3fv(camera, "pos", vector),
+                             [ vector, vector[0] ]),
+        ("ospSet3iv",        lambda : ospSet3iv(renderer, "dummy", intVector),
+                             [ intVector, intVector[0] ]),
+        ("renderFrame",      lambda : ospRenderFrame(framebuffer, renderer, channels),
+                             [ channels ] + channels),
+        ("renderFrame/bad",  renderBadChannels,
+                             [ badChannels ] + badChannels),
+        ("frameBufferClear", lambda : ospFrameBufferClear(framebuffer, channels),
+                             [ channels ] + channels),
+        ("newFrameBuffer",   lambda : ospRelease(ospNewFrameBuffer([4,4], "srgba", channels)),
+                             [ channels ] + channels),
+    ]
+
+def checkCase(name, call, inputs, iterations, rssLimit) :
+    ## warm up first, so caches, scratch buffers and the allocator's
+    ## pools are as big as they get before measuring
+    for i in range(max(1, iterations // 10)) :
+        call()
+    refCounts = [ sys.getrefcount(x) for x in inputs ]
+    rss = residentBytes()
+    for i in range(iterations) :
+        call()
+    rssGrowth = residentBytes() - rss
+    ## counted the same way as above, so the extra references that
+    ## the counting itself holds cancel out
+    refGrowth = [ sys.getrefcount(x) for x in inputs ]
+    refGrowth = [ now - before for now, before in zip(refGrowth, refCounts) ]
+
+    leaks = [ "refcount of input %d %+d" % (i, d) for i, d in enumerate(refGrowth) if d ]
+    if rssGrowth > rssLimit :
+        leaks.append("rss +%.1f MB" % (rssGrowth / 1e6))
+    print("%-18s %8d calls  rss %+8.2f MB  %s" % (name, iterations, rssGrowth / 1e6,
+                                                 "LEAK: " + ", ".join(leaks) if leaks else "ok"))
+    sys.stdout.flush()
+    return not leaks
+
+def main() :
+    parser = argparse.ArgumentParser(description="leak check for the list conversions of the ospray python bindings")
+    parser.add_argument("--iterations", type=int, default=20000,
+                        help="calls per case (default 20000)")
+    parser.add_argument("--cases", help="comma separated subset of the cases (default: all)")
+    parser.add_argument("--rss-limit", type=float, default=2.0,
+                        help="RSS growth in MB that counts as a leak (default 2)")
+    args = parser.parse_args()
+
+    ospray.ospInit()
+    cases = makeCases()
+    if args.cases :
+        names = [ name for name, call, inputs in cases ]
+        selected = [ c for c in args.cases.split(",") if c ]
+        for c in selected :
+            if c not in names :
+                parser.error("unknown case '%s' (cases: %s)" % (c, ", ".join(names)))
+        cases = [ case for case in cases if case[0] in selected ]
+
+    numLeaks = 0
+    for name, call, inputs in cases :
+        numLeaks += not checkCase(name, call, inputs, args.iterations, args.rss_limit * 1e6)
+    print("\n%d of %d case(s) leak" % (numLeaks, len(cases)))
+    ospShutdown()
+    return 1 if numLeaks else 0
+
+sys.exit(main())
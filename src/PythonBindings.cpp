@@ -18,46 +18,684 @@
 #include "ospray/ospray.h"
 #include <iostream>
 #include <vector>
+#include <map>
+#include <set>
+#include <unordered_map>
+#include <list>
+#include <stdexcept>
+#include <exception>
+#include <system_error>
+#include <initializer_list>
+#include <string>
+#include <cstring>
+#include <cctype>
+#include <cerrno>
+#include <climits>
+#include <limits>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <chrono>
 
-#define STB_IMAGE_WRITE_IMPLEMENTATION 1
-#include "3rdParty/stb_image_write.h"
+#include <atomic>
+#include <algorithm>
+#include <type_traits>
+#include <cmath>
+#include <zlib.h>
+#ifdef _WIN32
+# include <cstdio>
+#else
+# include <sys/mman.h>
+# include <sys/stat.h>
+# include <fcntl.h>
+# include <unistd.h>
+#endif
+#ifdef __SSSE3__
+# include <tmmintrin.h>
+#endif
 
 /* static PyObject *SpamError; */
 
+/*! runs task(begin,end) on blocks of rows [begin,end) that together
+    cover [0,numRows), using (up to) all hardware threads; returns
+    once all blocks are done */
+template<typename Task>
+void parallelForRows(int numRows, int rowsPerBlock, const Task &task)
+{
+  const int numBlocks = (numRows+rowsPerBlock-1)/rowsPerBlock;
+  const int numThreads
+    = std::min<int>(numBlocks,std::max(1u,std::thread::hardware_concurrency()));
+  std::atomic<int> nextBlock(0);
+  auto worker = [&]() {
+    for (int block; (block = nextBlock++) < numBlocks; )
+      task(block*rowsPerBlock,std::min(numRows,(block+1)*rowsPerBlock));
+  };
+  std::vector<std::thread> threads;
+  for (int i=1;i<numThreads;i++)
+    threads.emplace_back(worker);
+  worker();
+  for (auto &t : threads) t.join();
+}
+
+/*! strips the alpha channel off a row of RGBA8 pixels */
+inline void rgbaToRgb(unsigned char *out, const uint32_t *in, int numPixels)
+{
+  int x = 0;
+#ifdef __SSSE3__
+  // 4 pixels per shuffle; each store writes 16 bytes of which only
+  // the first 12 are valid, so stop while that still fits the row
+  const __m128i strip = _mm_setr_epi8(0,1,2,4,5,6,8,9,10,12,13,14,-1,-1,-1,-1);
+  for (; x+6 <= numPixels; x += 4)
+    _mm_storeu_si128((__m128i*)(out+3*x),
+                     _mm_shuffle_epi8(_mm_loadu_si128((const __m128i*)(in+x)),strip));
+#endif
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+  // 4 pixels at a time, packed into three 32-bit words
+  for (; x+4 <= numPixels; x += 4) {
+    const uint32_t p0 = in[x+0], p1 = in[x+1], p2 = in[x+2], p3 = in[x+3];
+    const uint32_t packed[3] = {
+      (p0 & 0xffffff)         | (p1 << 24),
+      ((p1 >> 8) & 0xffff)    | (p2 << 16),
+      ((p2 >> 16) & 0xff)     | (p3 << 8)
+    };
+    memcpy(out+3*x,packed,sizeof(packed));
+  }
+#endif
+  const unsigned char *bytes = (const unsigned char *)in;
+  for (; x < numPixels; x++) {
+    out[3*x + 0] = bytes[4*x + 0];
+    out[3*x + 1] = bytes[4*x + 1];
+    out[3*x + 2] = bytes[4*x + 2];
+  }
+}
+
+/*! opens an image file for writing; throws on error */
+FILE *openImageFile(const char *fileName)
+{
+  FILE *file = fopen(fileName, "wb");
+  if (!file)
+    throw std::runtime_error(std::string("could not open '")+fileName
+                             +"' for writing: "+strerror(errno));
+  return file;
+}
+
+/*! closes a file from openImageFile; throws if any of the writes to
+    it failed */
+void closeImageFile(FILE *file, const char *fileName)
+{
+  const bool ok = !ferror(file);
+  if (fclose(file) != 0 || !ok)
+    throw std::runtime_error(std::string("error writing '")+fileName+"'");
+}
+
 // helper function to write the rendered image as PPM file
 void writePPM(const char *fileName,
               const osp::vec2i &size,
               const uint32_t *pixel)
 {
-  FILE *file = fopen(fileName, "wb");
-  if (!file) {
-    fprintf(stderr, "fopen('%s', 'wb') failed: %d", fileName, errno);
-    return;
-  }
+  FILE *file = openImageFile(fileName);
   fprintf(file, "P6\n%i %i\n255\n", size.x, size.y);
-  unsigned char *out = (unsigned char *)alloca(3*size.x);
-  for (int y = 0; y < size.y; y++) {
-    const unsigned char *in = (const unsigned char *)&pixel[(size.y-1-y)*size.x];
-    for (int x = 0; x < size.x; x++) {
-      out[3*x + 0] = in[4*x + 0];
-      out[3*x + 1] = in[4*x + 1];
-      out[3*x + 2] = in[4*x + 2];
+  // convert all rows in parallel (flipping them, since ospray's
+  // first row is the bottom one), then write them in one go
+  std::vector<unsigned char> out(3*size_t(size.x)*size.y);
+  parallelForRows(size.y,64,[&](int begin, int end) {
+      for (int y = begin; y < end; y++)
+        rgbaToRgb(&out[3*size_t(size.x)*y],&pixel[size_t(size.y-1-y)*size.x],size.x);
+    });
+  fwrite(out.data(), out.size(), sizeof(char), file);
+  fprintf(file, "\n");
+  closeImageFile(file,fileName);
+}
+
+/*! applies the PNG filter of given type to one row of RGBA8 pixels
+    ('prev' is the row above, or null for the first row) */
+inline void filterPNGRow(unsigned char *out, int filter,
+                         const unsigned char *row, const unsigned char *prev,
+                         int numBytes)
+{
+  const int bpp = 4;
+  for (int i = 0; i < numBytes; i++) {
+    const int a = i >= bpp ? row[i-bpp] : 0;
+    const int b = prev ? prev[i] : 0;
+    const int c = (prev && i >= bpp) ? prev[i-bpp] : 0;
+    int predicted = 0;
+    switch (filter) {
+    case 1: predicted = a; break;
+    case 2: predicted = b; break;
+    case 3: predicted = (a+b)/2; break;
+    case 4: {
+      const int p = a+b-c, pa = abs(p-a), pb = abs(p-b), pc = abs(p-c);
+      predicted = (pa <= pb && pa <= pc) ? a : (pb <= pc ? b : c);
+    } break;
     }
-    fwrite(out, 3*size.x, sizeof(char), file);
+    out[i] = (unsigned char)(row[i]-predicted);
   }
-  fprintf(file, "\n");
-  fclose(file);
 }
 
-// helper function to write the rendered image as PNG file
+/*! writes one PNG chunk (length, type, data, crc) */
+void writePNGChunk(FILE *file, const char *type, const unsigned char *data, size_t size)
+{
+  const unsigned char length[4] = {
+    (unsigned char)(size>>24), (unsigned char)(size>>16),
+    (unsigned char)(size>>8),  (unsigned char)size
+  };
+  uLong crc = crc32(0L,(const Bytef*)type,4);
+  if (size) crc = crc32(crc,data,size);
+  const unsigned char crcBytes[4] = {
+    (unsigned char)(crc>>24), (unsigned char)(crc>>16),
+    (unsigned char)(crc>>8),  (unsigned char)crc
+  };
+  fwrite(length,4,1,file);
+  fwrite(type,4,1,file);
+  if (size) fwrite(data,size,1,file);
+  fwrite(crcBytes,4,1,file);
+}
+
+// helper function to write the rendered image as PNG file.
+//
+// Rows get filtered and deflated in parallel stripes, each of which
+// ends in a byte-aligned (sync-flushed) deflate block so the stripes
+// simply concatenate into one zlib stream (the way pigz does it);
+// each stripe goes into its own IDAT chunk. compressionLevel is
+// zlib's (0=store only, 1=fastest, ..., 9=best, -1=default); all but
+// the store level pick the best filter per row, like libpng does.
+// The file only gets created once all stripes compressed fine
 void writePNG(const std::string &fileName,
               const osp::vec2i &fbSize,
-              const uint32_t *pixel)
+              const uint32_t *pixel,
+              int compressionLevel = Z_DEFAULT_COMPRESSION)
+{
+  const int rowBytes      = 4*fbSize.x;
+  const int rowsPerStripe = std::max(32,fbSize.y/int(4*std::max(1u,std::thread::hardware_concurrency())));
+  const int numStripes    = (fbSize.y+rowsPerStripe-1)/rowsPerStripe;
+  struct Stripe {
+    std::vector<unsigned char> deflated;
+    uLong                      adler;
+    size_t                     numBytes;
+    bool                       ok;
+  };
+  std::vector<Stripe> stripes(numStripes);
+
+  parallelForRows(fbSize.y,rowsPerStripe,[&](int begin, int end) {
+      Stripe &stripe = stripes[begin/rowsPerStripe];
+      // png rows go top to bottom, ospray's bottom to top
+      auto row = [&](int y) {
+        return (const unsigned char *)&pixel[size_t(fbSize.y-1-y)*fbSize.x];
+      };
+      std::vector<unsigned char> filtered(size_t(end-begin)*(1+rowBytes));
+      std::vector<unsigned char> candidate(rowBytes);
+      for (int y = begin; y < end; y++) {
+        unsigned char *out = &filtered[size_t(y-begin)*(1+rowBytes)];
+        const unsigned char *prev = y > 0 ? row(y-1) : nullptr;
+        int bestFilter = 0;
+        if (compressionLevel != 0) {
+          // minimum sum of absolute (signed) differences heuristic
+          long bestCost = -1;
+          for (int filter = 0; filter < 5; filter++) {
+            filterPNGRow(candidate.data(),filter,row(y),prev,rowBytes);
+            long cost = 0;
+            for (int i = 0; i < rowBytes; i++)
+              cost += abs((signed char)candidate[i]);
+            if (bestCost < 0 || cost < bestCost) {
+              bestCost   = cost;
+              bestFilter = filter;
+            }
+          }
+        }
+        out[0] = bestFilter;
+        filterPNGRow(out+1,bestFilter,row(y),prev,rowBytes);
+      }
+
+      stripe.numBytes = filtered.size();
+      stripe.adler    = adler32(adler32(0L,Z_NULL,0),filtered.data(),filtered.size());
+
+      z_stream z;
+      memset(&z,0,sizeof(z));
+      stripe.ok = deflateInit2(&z,compressionLevel,Z_DEFLATED,-15,8,Z_DEFAULT_STRATEGY) == Z_OK;
+      if (!stripe.ok) return;
+      stripe.deflated.resize(deflateBound(&z,filtered.size())+64);
+      z.next_in   = filtered.data();
+      z.avail_in  = filtered.size();
+      z.next_out  = stripe.deflated.data();
+      z.avail_out = stripe.deflated.size();
+      const bool last = (end == fbSize.y);
+      const int  rc   = deflate(&z,last ? Z_FINISH : Z_SYNC_FLUSH);
+      stripe.ok = (last ? rc == Z_STREAM_END : rc == Z_OK) && z.avail_in == 0;
+      stripe.deflated.resize(z.total_out);
+      deflateEnd(&z);
+    });
+  for (auto &stripe : stripes)
+    if (!stripe.ok)
+      throw std::runtime_error("error compressing png image '"+fileName+"'");
+
+  FILE *file = openImageFile(fileName.c_str());
+
+  // signature and header
+  static const unsigned char signature[8] = { 137,80,78,71,13,10,26,10 };
+  fwrite(signature,8,1,file);
+  const unsigned char ihdr[13] = {
+    (unsigned char)(fbSize.x>>24), (unsigned char)(fbSize.x>>16),
+    (unsigned char)(fbSize.x>>8),  (unsigned char)fbSize.x,
+    (unsigned char)(fbSize.y>>24), (unsigned char)(fbSize.y>>16),
+    (unsigned char)(fbSize.y>>8),  (unsigned char)fbSize.y,
+    8, /* bits per channel */ 6, /* rgba */ 0, 0, 0
+  };
+  writePNGChunk(file,"IHDR",ihdr,sizeof(ihdr));
+
+  // zlib stream: header, concatenated stripes, combined checksum
+  const int level = compressionLevel < 0 ? 6 : compressionLevel;
+  unsigned char zlibHeader[2] = { 0x78, (unsigned char)((level < 2 ? 0 : level < 6 ? 1 : level == 6 ? 2 : 3) << 6) };
+  zlibHeader[1] += 31 - (zlibHeader[0]*256+zlibHeader[1]) % 31;
+  writePNGChunk(file,"IDAT",zlibHeader,2);
+  uLong adler = adler32(0L,Z_NULL,0);
+  for (auto &stripe : stripes) {
+    writePNGChunk(file,"IDAT",stripe.deflated.data(),stripe.deflated.size());
+    adler = adler32_combine(adler,stripe.adler,stripe.numBytes);
+  }
+  const unsigned char adlerBytes[4] = {
+    (unsigned char)(adler>>24), (unsigned char)(adler>>16),
+    (unsigned char)(adler>>8),  (unsigned char)adler
+  };
+  writePNGChunk(file,"IDAT",adlerBytes,4);
+  writePNGChunk(file,"IEND",nullptr,0);
+  closeImageFile(file,fileName.c_str());
+}
+
+/*! appends a 32-bit value to a byte stream, in little endian order */
+inline void appendLE32(std::vector<unsigned char> &out, uint32_t value)
+{
+  for (int i = 0; i < 4; i++)
+    out.push_back((unsigned char)(value >> (8*i)));
+}
+
+inline void appendLE32(std::vector<unsigned char> &out, float value)
+{
+  uint32_t bits;
+  memcpy(&bits,&value,sizeof(bits));
+  appendLE32(out,bits);
+}
+
+/*! appends an openexr header attribute */
+void appendEXRAttribute(std::vector<unsigned char> &out,
+                        const char *name, const char *type,
+                        const std::vector<unsigned char> &value)
+{
+  out.insert(out.end(),name,name+strlen(name)+1);
+  out.insert(out.end(),type,type+strlen(type)+1);
+  appendLE32(out,(uint32_t)value.size());
+  out.insert(out.end(),value.begin(),value.end());
+}
+
+// helper function to write float pixels as PFM file, with either 3
+// (color, 'PF') or 1 (grayscale, 'Pf') channels per pixel. PFM stores
+// rows bottom to top, just like ospray, so no flipping needed
+void writePFM(const char *fileName,
+              const osp::vec2i &size,
+              const float *pixel,
+              int numChannels)
+{
+  FILE *file = openImageFile(fileName);
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+  const char *scale = "1.0";
+#else
+  const char *scale = "-1.0";
+#endif
+  fprintf(file, "%s\n%i %i\n%s\n", numChannels == 3 ? "PF" : "Pf", size.x, size.y, scale);
+  fwrite(pixel, sizeof(float), size_t(numChannels)*size.x*size.y, file);
+  closeImageFile(file,fileName);
+}
+
+// helper function to write float pixels as uncompressed scan line
+// OpenEXR file; 'channelNames' are the names of the 'numChannels'
+// interleaved channels of each input pixel
+void writeEXR(const char *fileName,
+              const osp::vec2i &size,
+              const float *pixel,
+              int numChannels,
+              const char *const *channelNames)
+{
+  FILE *file = openImageFile(fileName);
+
+  // exr wants its channels sorted by name
+  std::vector<int> order(numChannels);
+  for (int i = 0; i < numChannels; i++) order[i] = i;
+  std::sort(order.begin(),order.end(),[&](int a, int b) {
+      return strcmp(channelNames[a],channelNames[b]) < 0;
+    });
+
+  std::vector<unsigned char> header = { 0x76, 0x2f, 0x31, 0x01 };
+  appendLE32(header,(uint32_t)2);
+  std::vector<unsigned char> value;
+  for (int c : order) {
+    value.insert(value.end(),channelNames[c],channelNames[c]+strlen(channelNames[c])+1);
+    appendLE32(value,(uint32_t)2); // FLOAT
+    appendLE32(value,(uint32_t)0); // pLinear, reserved
+    appendLE32(value,(uint32_t)1); // x sampling
+    appendLE32(value,(uint32_t)1); // y sampling
+  }
+  value.push_back(0);
+  appendEXRAttribute(header,"channels","chlist",value);
+  appendEXRAttribute(header,"compression","compression",{ 0 /* none */ });
+  value.clear();
+  appendLE32(value,(uint32_t)0);
+  appendLE32(value,(uint32_t)0);
+  appendLE32(value,(uint32_t)(size.x-1));
+  appendLE32(value,(uint32_t)(size.y-1));
+  appendEXRAttribute(header,"dataWindow","box2i",value);
+  appendEXRAttribute(header,"displayWindow","box2i",value);
+  appendEXRAttribute(header,"lineOrder","lineOrder",{ 0 /* increasing y */ });
+  value.clear();
+  appendLE32(value,1.f);
+  appendEXRAttribute(header,"pixelAspectRatio","float",value);
+  value.clear();
+  appendLE32(value,0.f);
+  appendLE32(value,0.f);
+  appendEXRAttribute(header,"screenWindowCenter","v2f",value);
+  value.clear();
+  appendLE32(value,1.f);
+  appendEXRAttribute(header,"screenWindowWidth","float",value);
+  header.push_back(0);
+
+  // offset table: one single-line block per row
+  const size_t lineBytes = 8+size_t(numChannels)*size.x*sizeof(float);
+  const size_t firstLine = header.size()+8*size_t(size.y);
+  for (int y = 0; y < size.y; y++) {
+    const uint64_t offset = firstLine+y*lineBytes;
+    appendLE32(header,(uint32_t)offset);
+    appendLE32(header,(uint32_t)(offset >> 32));
+  }
+  fwrite(header.data(), header.size(), sizeof(char), file);
+
+  // scan lines (top to bottom, so flipped), each channel planar
+  std::vector<unsigned char> lines;
+  lines.reserve(lineBytes*size.y);
+  lines.resize(lineBytes*size.y);
+  parallelForRows(size.y,64,[&](int begin, int end) {
+      std::vector<unsigned char> line;
+      line.reserve(lineBytes);
+      for (int y = begin; y < end; y++) {
+        const float *in = pixel+size_t(size.y-1-y)*size.x*numChannels;
+        line.clear();
+        appendLE32(line,(uint32_t)y);
+        appendLE32(line,(uint32_t)(lineBytes-8));
+        for (int c : order)
+          for (int x = 0; x < size.x; x++)
+            appendLE32(line,in[x*numChannels+c]);
+        memcpy(&lines[y*lineBytes],line.data(),lineBytes);
+      }
+    });
+  fwrite(lines.data(), lines.size(), sizeof(char), file);
+  closeImageFile(file,fileName);
+}
+
+/*! image file formats we can write */
+enum ImageFileType { IMAGE_PNG, IMAGE_PPM, IMAGE_PFM, IMAGE_EXR };
+
+/*! pixel layouts of the frame buffer channels we can write */
+enum PixelType { PIXEL_RGBA8, PIXEL_SRGBA8, PIXEL_RGBA32F, PIXEL_DEPTH32F };
+
+/*! size of one pixel of given type, in bytes */
+size_t pixelSize(PixelType type)
+{
+  switch (type) {
+  case PIXEL_RGBA32F:  return 4*sizeof(float);
+  case PIXEL_DEPTH32F: return sizeof(float);
+  default:             return sizeof(uint32_t);
+  }
+}
+
+/*! determine image file type from file name extension; throws if
+    there's none, or none we support */
+ImageFileType imageFileType(const std::string &fileName)
+{
+  size_t dotPos = fileName.rfind(".");
+  if (dotPos == std::string::npos)
+    throw std::runtime_error
+      ("invalid image file name '"
+       +fileName
+       +"' : cannot determine file format from extension");
+  const std::string ext = fileName.substr(dotPos);
+  if (ext == ".png" || ext == ".PNG") return IMAGE_PNG;
+  if (ext == ".ppm" || ext == ".PPM") return IMAGE_PPM;
+  if (ext == ".pfm" || ext == ".PFM") return IMAGE_PFM;
+  if (ext == ".exr" || ext == ".EXR") return IMAGE_EXR;
+  throw std::runtime_error("invalid/unsupported file name type '"+ext+"'");
+}
+
+/*! throws if pixels of given type cannot be written to given file type */
+void checkImageFileType(ImageFileType fileType, PixelType pixelType)
+{
+  if (pixelType == PIXEL_DEPTH32F && (fileType == IMAGE_PNG || fileType == IMAGE_PPM))
+    throw std::runtime_error("depth can only be saved as .pfm or .exr file");
+}
+
+inline float srgbToLinear(float c)
+{
+  return c <= 0.04045f ? c/12.92f : powf((c+0.055f)/1.055f,2.4f);
+}
+
+inline float linearToSrgb(float c)
+{
+  return c <= 0.0031308f ? 12.92f*c : 1.055f*powf(c,1.f/2.4f)-0.055f;
+}
+
+/*! converts float rgba pixels to (srgb-encoded) RGBA8 */
+std::vector<uint32_t> toRGBA8(const osp::vec2i &size, const float *pixel)
+{
+  std::vector<uint32_t> out(size_t(size.x)*size.y);
+  parallelForRows(size.y,64,[&](int begin, int end) {
+      for (size_t i = size_t(begin)*size.x; i < size_t(end)*size.x; i++) {
+        uint32_t rgba = 0;
+        for (int c = 0; c < 4; c++) {
+          float f = std::min(1.f,std::max(0.f,pixel[4*i+c]));
+          if (c < 3) f = linearToSrgb(f);
+          rgba |= uint32_t(f*255.f+.5f) << (8*c);
+        }
+        out[i] = rgba;
+      }
+    });
+  return out;
+}
+
+/*! converts pixels of given type to linear float, with 1 (depth), 3
+    (rgb), or 4 (rgba) channels per pixel */
+std::vector<float> toFloats(const osp::vec2i &size, PixelType type,
+                            const void *pixels, int numChannels)
+{
+  float srgbTable[256];
+  for (int i = 0; i < 256; i++)
+    srgbTable[i] = (type == PIXEL_SRGBA8) ? srgbToLinear(i/255.f) : i/255.f;
+
+  std::vector<float> out(size_t(numChannels)*size.x*size.y);
+  parallelForRows(size.y,64,[&](int begin, int end) {
+      for (size_t i = size_t(begin)*size.x; i < size_t(end)*size.x; i++)
+        for (int c = 0; c < numChannels; c++) {
+          float &f = out[numChannels*i+c];
+          switch (type) {
+          case PIXEL_DEPTH32F: f = ((const float *)pixels)[i]; break;
+          case PIXEL_RGBA32F:  f = ((const float *)pixels)[4*i+c]; break;
+          default: {
+            const unsigned char v = ((const unsigned char *)pixels)[4*i+c];
+            f = (c < 3) ? srgbTable[v] : v/255.f;
+          }
+          }
+        }
+    });
+  return out;
+}
+
+/*! write pixels of given type (in ospray's bottom-to-top row order)
+    to an image file of given type; throws if the file can't be
+    written */
+void writeImage(const std::string &fileName, ImageFileType fileType,
+                const osp::vec2i &size, PixelType pixelType,
+                const void *pixels, int compressionLevel)
+{
+  switch (fileType) {
+  case IMAGE_PNG:
+  case IMAGE_PPM: {
+    std::vector<uint32_t> converted;
+    const uint32_t *rgba8 = (const uint32_t *)pixels;
+    if (pixelType == PIXEL_RGBA32F) {
+      converted = toRGBA8(size,(const float *)pixels);
+      rgba8 = converted.data();
+    }
+    if (fileType == IMAGE_PNG)
+      writePNG(fileName,size,rgba8,compressionLevel);
+    else
+      writePPM(fileName.c_str(),size,rgba8);
+  } break;
+  case IMAGE_PFM: {
+    const int numChannels = pixelType == PIXEL_DEPTH32F ? 1 : 3;
+    std::vector<float> floats = toFloats(size,pixelType,pixels,numChannels);
+    writePFM(fileName.c_str(),size,floats.data(),numChannels);
+  } break;
+  case IMAGE_EXR: {
+    static const char *colorChannels[] = { "R", "G", "B", "A" };
+    static const char *depthChannels[] = { "Z" };
+    const bool depth = pixelType == PIXEL_DEPTH32F;
+    std::vector<float> floats = toFloats(size,pixelType,pixels,depth ? 1 : 4);
+    writeEXR(fileName.c_str(),size,floats.data(),depth ? 1 : 4,
+             depth ? depthChannels : colorChannels);
+  } break;
+  }
+}
+
+
+
+
+// ##################################################################
+// instrumentation
+// ##################################################################
+
+/*! per-function call statistics. Every function in the module's
+    method table gets called through a small trampoline that records
+    these - but only while stats are enabled; otherwise all the
+    trampoline costs is one indirection and a flag check. Counters are
+    atomic since functions may run concurrently with the GIL released */
+struct FunctionStats {
+  const char           *name;
+  std::atomic<uint64_t> numCalls  { 0 };
+  std::atomic<uint64_t> totalNs   { 0 };
+  std::atomic<uint64_t> maxNs     { 0 };
+  std::atomic<uint64_t> numBytes  { 0 };
+
+  void reset() { numCalls = 0; totalNs = 0; maxNs = 0; numBytes = 0; }
+};
+
+/*! one call, for chrome://tracing ('complete' event) */
+struct TraceEvent {
+  const char *name;
+  uint64_t    beginNs;
+  uint64_t    durationNs;
+  size_t      thread;
+};
+
+static std::atomic<bool>       statsEnabled { false };
+static std::atomic<bool>       traceEnabled { false };
+static std::mutex              traceMutex;
+static std::vector<TraceEvent> traceEvents;
+static const size_t            maxTraceEvents = 1<<20;
+/*! the instrumented call currently running on this thread, if any */
+static thread_local FunctionStats *currentCall = nullptr;
+
+inline uint64_t nowNs()
+{
+  return std::chrono::duration_cast<std::chrono::nanoseconds>
+    (std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+/*! account given number of bytes converted or copied to the function
+    currently being called */
+inline void countBytes(size_t numBytes)
 {
-  stbi_write_png(fileName.c_str(),fbSize.x,fbSize.y,4,
-                 pixel,fbSize.x*sizeof(uint32_t));
+  if (currentCall) currentCall->numBytes += numBytes;
 }
 
+/*! records time (and trace event) of one call; only to be used while
+    stats are enabled */
+struct CallScope {
+  FunctionStats *stats;
+  FunctionStats *outer;
+  uint64_t       begin;
+
+  CallScope(FunctionStats *stats)
+    : stats(stats), outer(currentCall), begin(nowNs())
+  { currentCall = stats; }
+
+  ~CallScope()
+  {
+    const uint64_t ns = nowNs()-begin;
+    currentCall = outer;
+    stats->numCalls++;
+    stats->totalNs += ns;
+    uint64_t max = stats->maxNs;
+    while (ns > max && !stats->maxNs.compare_exchange_weak(max,ns));
+    if (traceEnabled) {
+      std::lock_guard<std::mutex> lock(traceMutex);
+      if (traceEvents.size() < maxTraceEvents)
+        traceEvents.push_back({ stats->name, begin, ns,
+              std::hash<std::thread::id>()(std::this_thread::get_id()) });
+    }
+  }
+};
+
+
+
+// ##################################################################
+// object handles
+// ##################################################################
+
+/*! python object holding an ospray object handle. Objects created
+    through these bindings are returned as one of these (of the
+    respective subtype: Camera, Renderer, ...); when the python object
+    dies, its handle goes onto a queue of deferred releases rather than
+    getting released right away (see drainReleases) */
+struct ObjectWrapper {
+  PyObject_HEAD
+  OSPObject handle;
+};
+
+static PyTypeObject ObjectType           = { PyVarObject_HEAD_INIT(NULL, 0) };
+static PyTypeObject CameraType           = { PyVarObject_HEAD_INIT(NULL, 0) };
+static PyTypeObject RendererType         = { PyVarObject_HEAD_INIT(NULL, 0) };
+static PyTypeObject LightType            = { PyVarObject_HEAD_INIT(NULL, 0) };
+static PyTypeObject ModelType            = { PyVarObject_HEAD_INIT(NULL, 0) };
+static PyTypeObject GeometryType         = { PyVarObject_HEAD_INIT(NULL, 0) };
+static PyTypeObject DataType             = { PyVarObject_HEAD_INIT(NULL, 0) };
+static PyTypeObject FrameBufferType      = { PyVarObject_HEAD_INIT(NULL, 0) };
+static PyTypeObject VolumeType           = { PyVarObject_HEAD_INIT(NULL, 0) };
+static PyTypeObject TransferFunctionType = { PyVarObject_HEAD_INIT(NULL, 0) };
+
+/*! every object created through these bindings that hasn't been
+    released yet, with its wrapper (or null while it has none: once
+    that is gone, and the handle is waiting in 'pendingReleases', or
+    until ospBatch returns an object it created). Only accessed with
+    the GIL held */
+static std::map<OSPObject,ObjectWrapper *> liveObjects;
+/*! handles whose wrappers died, to be released by drainReleases */
+static std::vector<OSPObject> pendingReleases;
+
+void releaseObject(OSPObject object);
+
+/*! returns a new wrapper of given type for given (new) handle */
+PyObject *wrapObject(OSPObject handle, PyTypeObject *type)
+{
+  if (!handle) {
+    PyErr_SetString(PyExc_RuntimeError,"ospray could not create object");
+    return NULL;
+  }
+  ObjectWrapper *wrapper = PyObject_New(ObjectWrapper,type);
+  if (!wrapper) {
+    releaseObject(handle);
+    return NULL;
+  }
+  wrapper->handle     = handle;
+  liveObjects[handle] = wrapper;
+  return (PyObject *)wrapper;
+}
 
 
 
@@ -67,285 +705,5429 @@ void writePNG(const std::string &fileName,
 
 OSPFrameBufferFormat parseFrameBufferFormat(const std::string &format)
 {
-  if (format == "srgba") return OSP_FB_SRGBA;
+  if (format == "srgba")   return OSP_FB_SRGBA;
+  if (format == "rgba8")   return OSP_FB_RGBA8;
+  if (format == "rgba32f") return OSP_FB_RGBA32F;
+  if (format == "none")    return OSP_FB_NONE;
   throw std::runtime_error("unkown frame buffer format '"+format+"'");
 }
 
 /*! given a list iterator elemnt (that is suppsoed to point to a
-    number object), convert that to float, if possible */
-std::string getString(PyObject *iter)
+    string object), return its characters; the pointer is only valid
+    as long as the object is */
+const char *getCString(PyObject *iter)
 {
-  if (PyString_Check(iter)) 
-    return PyString_AsString(iter);
+  if (PyUnicode_Check(iter)) {
+    const char *chars = PyUnicode_AsUTF8(iter);
+    if (chars) return chars;
+    PyErr_Clear();
+  }
   throw std::runtime_error("argument is not a string or string-compatible type ...!?");
 }
 
 /*! given a list iterator elemnt (that is suppsoed to point to a
-    number object), convert that to float, if possible */
-float getFloat(PyObject *iter)
+    string object), convert that to a std::string, if possible */
+std::string getString(PyObject *iter)
+{
+  return getCString(iter);
+}
+
+/*! throws if the python number conversion that just returned the
+    error value (-1) failed - e.g., for an int too large for a C long
+    or a double - rather than going on with that value and a python
+    error still set. Keeps python's message; overflows throw a
+    std::overflow_error */
+void checkNumberConversion()
 {
+  if (!PyErr_Occurred())
+    return;
+  PyObject *type, *value, *traceback;
+  PyErr_Fetch(&type,&value,&traceback);
+  const bool overflow = PyErr_GivenExceptionMatches(type,PyExc_OverflowError);
+  std::string message = "number out of range";
+  PyObject *str = value ? PyObject_Str(value) : NULL;
+  const char *chars = str ? PyUnicode_AsUTF8(str) : NULL;
+  if (chars)
+    message = chars;
+  PyErr_Clear();
+  Py_XDECREF(str);
+  Py_XDECREF(type);
+  Py_XDECREF(value);
+  Py_XDECREF(traceback);
+  if (overflow)
+    throw std::overflow_error(message);
+  throw std::runtime_error(message);
+}
+
+/*! given a list iterator elemnt (that is suppsoed to point to a
+    number object), convert that to double, if possible */
+double getDouble(PyObject *iter)
+{
+  if (PyFloat_CheckExact(iter))
+    return PyFloat_AS_DOUBLE(iter);
+  double value;
   if (PyFloat_Check(iter)) 
-    return (float)PyFloat_AsDouble(iter);
-  if (PyLong_Check(iter)) 
-    return (float)PyLong_AsLong(iter);
-  if (PyInt_Check(iter)) 
-    return (float)PyInt_AsLong(iter);
-  throw std::runtime_error("argument is not a float or float-compatible type ...!?");
+    value = PyFloat_AsDouble(iter);
+  else if (PyLong_Check(iter)) 
+    value = PyLong_AsDouble(iter);
+  else
+    throw std::runtime_error("argument is not a float or float-compatible type ...!?");
+  if (value == -1.0)
+    checkNumberConversion();
+  return value;
 }
 
 /*! given a list iterator elemnt (that is suppsoed to point to a
     number object), convert that to float, if possible */
-int getInt(PyObject *iter)
+float getFloat(PyObject *iter)
 {
-  if (PyFloat_Check(iter)) 
-    return (int)PyFloat_AsDouble(iter);
-  if (PyLong_Check(iter)) 
-    return (int)PyLong_AsLong(iter);
-  if (PyInt_Check(iter)) 
-    return (int)PyInt_AsLong(iter);
+  return (float)getDouble(iter);
+}
+
+/*! given a list iterator elemnt (that is suppsoed to point to a
+    number object), convert that to a 64-bit int, if possible */
+long long getLongLong(PyObject *iter)
+{
+  if (PyLong_Check(iter)) {
+    const long long value = PyLong_AsLongLong(iter);
+    if (value == -1)
+      checkNumberConversion();
+    return value;
+  }
+  if (PyFloat_Check(iter)) {
+    const double value = getDouble(iter);
+    // also rejects nan
+    if (!(value >= -9223372036854775808.0 && value < 9223372036854775808.0))
+      throw std::overflow_error("float out of range for a 64-bit int");
+    return (long long)value;
+  }
   throw std::runtime_error("argument is not a int or int-compatible type ...!?");
 }
 
 /*! given a list iterator elemnt (that is suppsoed to point to a
-    number object), convert that to float, if possible */
+    number object), convert that to a 32-bit int, if possible */
+int getInt(PyObject *iter)
+{
+  const long long value = getLongLong(iter);
+  if (value < INT_MIN || value > INT_MAX)
+    throw std::overflow_error("value "+std::to_string(value)+" does not fit in 32 bits");
+  return (int)value;
+}
+
+/*! given a list iterator elemnt (that is suppsoed to point to a
+    number object), convert that to long, if possible */
 long getLong(PyObject *iter)
 {
-  if (PyLong_Check(iter)) 
-    return (long)PyLong_AsLong(iter);
-  if (PyInt_Check(iter)) 
-    return (long)PyInt_AsLong(iter);
+  if (PyLong_Check(iter)) {
+    const long value = PyLong_AsLong(iter);
+    if (value == -1)
+      checkNumberConversion();
+    return value;
+  }
   throw std::runtime_error("argument is not a long int or long int-compatible type ...!?");
 }
 
+/*! given a list iterator elemnt (that is suppsoed to point to an
+    object wrapper, or an int holding a live object handle), return
+    the handle. Ints are only accepted if they are the handle of an
+    object that is still alive, so a stray number raises rather than
+    crashing ospray. Handles are pointers, so they must not go through
+    a C 'long' (which is only 32 bits wide on some platforms) */
+OSPObject getHandle(PyObject *iter)
+{
+  if (PyObject_TypeCheck(iter,&ObjectType)) {
+    OSPObject handle = ((ObjectWrapper *)iter)->handle;
+    if (!handle)
+      throw std::runtime_error("object was already released");
+    return handle;
+  }
+  if (PyLong_Check(iter)) {
+    OSPObject handle = (OSPObject)PyLong_AsVoidPtr(iter);
+    if (!handle && PyErr_Occurred()) {
+      PyErr_Clear();
+      throw std::runtime_error("argument is not an object handle ...!?");
+    }
+    if (!liveObjects.count(handle))
+      throw std::runtime_error("argument is not the handle of a live object");
+    return handle;
+  }
+  throw std::runtime_error("argument is not an object handle ...!?");
+}
+
+/*! "O&" converter for PyArg_ParseTuple that reads an object handle
+    into any OSPxyz handle variable */
+int parseHandle(PyObject *object, void *handle)
+{
+  try {
+    *(OSPObject *)handle = getHandle(object);
+    return 1;
+  } catch (const std::runtime_error &e) {
+    PyErr_SetString(PyExc_TypeError,e.what());
+    return 0;
+  }
+}
+
+/*! owned reference to a list, tuple, or any other iterable, viewed
+    through PySequence_Fast (which for lists and tuples is the object
+    itself, and only for other iterables makes a temporary list). The
+    items are borrowed from the sequence, so there's nothing for the
+    converters below to release per item */
+struct FastSequence {
+  PyObject *seq;
+
+  FastSequence(PyObject *object)
+    : seq(PySequence_Fast(object,"not a sequence"))
+  {
+    if (!seq) {
+      PyErr_Clear();
+      throw std::runtime_error("argument is not a list, tuple, or other sequence!?");
+    }
+  }
+  ~FastSequence() { Py_DECREF(seq); }
+
+  size_t    size() const { return PySequence_Fast_GET_SIZE(seq); }
+  PyObject *operator[](size_t i) const { return PySequence_Fast_GET_ITEM(seq,i); }
+};
+
+/*! converts all items of a sequence with given converter, into the
+    (re-used, so usually already allocated) 'values' vector */
+template<typename T, typename Convert>
+void convertSequence(PyObject *valuesList, std::vector<T> &values, Convert convert)
+{
+  FastSequence seq(valuesList);
+  const size_t numValues = seq.size();
+  values.resize(numValues);
+  for (size_t i = 0; i < numValues; i++)
+    values[i] = convert(seq[i]);
+  countBytes(numValues*sizeof(T));
+}
+
 /*! converts a list object to a vector of floats. THe list obviously
     is expected to contains number objects (ints and longs get
     automatically converted to floats) */
-std::vector<float> getFloats(PyObject *valuesList)
+void getFloats(PyObject *valuesList, std::vector<float> &values)
 {
-  PyObject *iter = PyObject_GetIter(valuesList);
-  if (!iter) 
-    throw std::runtime_error("parameter to ospSet3fv is not a list!?");
+  convertSequence(valuesList,values,getFloat);
+}
 
+std::vector<float> getFloats(PyObject *valuesList)
+{
   std::vector<float> values;
-  if (iter)
-    while (PyObject *item = PyIter_Next(iter)) {
-      values.push_back(getFloat(item));
-    }
+  getFloats(valuesList,values);
   return values;
 }
 
 /*! converts a list object to a vector of strings. THe list obviously
-    is expected to contains number objects (ints and longs get
-    automatically converted to strings) */
+    is expected to contains string objects */
 std::vector<std::string> getStrings(PyObject *valuesList)
 {
-  PyObject *iter = PyObject_GetIter(valuesList);
-  if (!iter) 
-    throw std::runtime_error("parameter to ospSet3fv is not a list!?");
-
+  FastSequence seq(valuesList);
   std::vector<std::string> values;
-  if (iter)
-    while (PyObject *item = PyIter_Next(iter)) {
-      values.push_back(getString(item));
-    }
+  values.reserve(seq.size());
+  for (size_t i = 0; i < seq.size(); i++)
+    values.push_back(getString(seq[i]));
   return values;
 }
 
 /*! converts a list object to a vector of ints. THe list obviously
     is expected to contains number objects (ints and longs get
     automatically converted to ints) */
-std::vector<int> getInts(PyObject *valuesList)
+void getInts(PyObject *valuesList, std::vector<int> &values)
 {
-  PyObject *iter = PyObject_GetIter(valuesList);
-  if (!iter) 
-    throw std::runtime_error("parameter to ospSet3fv is not a list!?");
+  convertSequence(valuesList,values,getInt);
+}
 
+std::vector<int> getInts(PyObject *valuesList)
+{
   std::vector<int> values;
-  if (iter)
-    while (PyObject *item = PyIter_Next(iter)) {
-      values.push_back(getInt(item));
-    }
+  getInts(valuesList,values);
   return values;
 }
 
-/*! converts a list object to a vector of longs. THe list obviously
-    is expected to contains number objects (longs and longs get
-    automatically converted to longs) */
-std::vector<long> getLongs(PyObject *valuesList)
+/*! converts a list object to a vector of object handles */
+void getHandles(PyObject *valuesList, std::vector<OSPObject> &values)
 {
-  PyObject *iter = PyObject_GetIter(valuesList);
-  if (!iter) 
-    throw std::runtime_error("parameter to ospSet3fv is not a list!?");
+  convertSequence(valuesList,values,getHandle);
+}
 
-  std::vector<long> values;
-  if (iter)
-    while (PyObject *item = PyIter_Next(iter)) {
-      values.push_back(getLong(item));
-    }
+std::vector<OSPObject> getHandles(PyObject *valuesList)
+{
+  std::vector<OSPObject> values;
+  getHandles(valuesList,values);
   return values;
 }
 
 
 
+/*! converts a sequence of exactly 'numValues' items into a fixed-size
+    array (no allocation, for the small vector setters) */
+template<typename T, typename Convert>
+void convertSequence(PyObject *valuesList, T *values, size_t numValues, Convert convert)
+{
+  FastSequence seq(valuesList);
+  if (seq.size() != numValues)
+    throw std::runtime_error("expected a list of "+std::to_string(numValues)
+                             +" values, got "+std::to_string(seq.size()));
+  for (size_t i = 0; i < numValues; i++)
+    values[i] = convert(seq[i]);
+}
 
+void getFloats(PyObject *valuesList, float *values, size_t numValues)
+{
+  convertSequence(valuesList,values,numValues,getFloat);
+}
 
-// ##################################################################
-// actual API functions
-// ##################################################################
+void getInts(PyObject *valuesList, int *values, size_t numValues)
+{
+  convertSequence(valuesList,values,numValues,getInt);
+}
 
 
-// ==================================================================
-// misc
-// ==================================================================
 
-// ------------------------------------------------------------------
-// ospInit
-// ------------------------------------------------------------------
-extern "C" PyObject *ospray_init(PyObject *self, PyObject *args)
+/*! a frame buffer channel name, with its interned python string */
+struct ChannelName {
+  const char *name;
+  uint32_t    flag;
+  PyObject   *interned;
+};
+
+static ChannelName channelNames[] = {
+  { "color",    OSP_FB_COLOR,    nullptr },
+  { "depth",    OSP_FB_DEPTH,    nullptr },
+  { "accum",    OSP_FB_ACCUM,    nullptr },
+  { "variance", OSP_FB_VARIANCE, nullptr },
+};
+
+/*! intern all channel names; to be called during module init. String
+    literals in python code are interned as well, so the channel lists
+    passed in per frame usually match by pointer */
+int initChannelNames()
 {
-  ospInit(0,nullptr);
-  Py_INCREF(Py_None);
-  return Py_None;
+  for (auto &channel : channelNames)
+    if (!channel.interned
+        && !(channel.interned = PyUnicode_InternFromString(channel.name)))
+      return -1;
+  return 0;
 }
 
-// ------------------------------------------------------------------
-// ospShutdown
-// ------------------------------------------------------------------
-extern "C" PyObject *ospray_shutdown(PyObject *self, PyObject *args)
+/*! converts a list of channel names ('color', 'depth', 'accum',
+    'variance') to
+    the respective bit mask of OSP_FB_xyz flags */
+uint32_t parseChannels(PyObject *channelsList)
 {
-  ospShutdown();
-  Py_INCREF(Py_None);
-  return Py_None;
+  FastSequence seq(channelsList);
+  uint32_t channels = 0;
+  for (size_t i = 0; i < seq.size(); i++) {
+    PyObject *item = seq[i];
+    bool found = false;
+    for (auto &channel : channelNames)
+      if (item == channel.interned) {
+        channels |= channel.flag;
+        found = true;
+        break;
+      }
+    if (found) continue;
+    // not interned (e.g., built at runtime): compare characters
+    const char *name = getCString(item);
+    for (auto &channel : channelNames)
+      if (!strcmp(name,channel.name))
+        channels |= channel.flag;
+  }
+  return channels;
 }
 
-// ------------------------------------------------------------------
-// ospCommit
-// ------------------------------------------------------------------
-extern "C" PyObject *ospray_commit(PyObject *self, PyObject *args)
+/*! parses a list of channel names into 'channels'; on error sets a
+    TypeError naming the function */
+bool parseChannelsArg(const char *function, PyObject *channelsList, uint32_t &channels)
 {
-  // arguments:
-  OSPObject object;
-  if (!PyArg_ParseTuple(args, "l", &object)) 
-    return NULL;
-  ospCommit((OSPObject)object);
-  Py_INCREF(Py_None);
-  return Py_None;
+  try {
+    channels = parseChannels(channelsList);
+    return true;
+  } catch (const std::runtime_error &e) {
+    PyErr_SetString(PyExc_TypeError,(std::string(function)+": "+e.what()).c_str());
+    return false;
+  }
 }
 
-// ------------------------------------------------------------------
-// ospAddGeometry
-// ------------------------------------------------------------------
-extern "C" PyObject *ospray_addGeometry(PyObject *self, PyObject *args)
+
+
+/*! argument helpers for METH_FASTCALL functions, which get their
+    arguments as a plain array instead of a tuple to be parsed. These
+    all return false (with a python exception set) on error */
+bool checkNumArgs(const char *function, Py_ssize_t nargs, Py_ssize_t expected)
 {
-  // arguments:
-  OSPObject model;
-  OSPObject geom;
-  if (!PyArg_ParseTuple(args, "ll", &model,&geom)) 
-    return NULL;
-  ospAddGeometry((OSPModel)model,(OSPGeometry)geom);
-  Py_INCREF(Py_None);
-  return Py_None;
+  if (nargs == expected) return true;
+  PyErr_Format(PyExc_TypeError,"%s() takes exactly %zd arguments (%zd given)",
+               function,expected,nargs);
+  return false;
+}
+
+bool parseArg(PyObject *arg, const char *&value)
+{
+  value = PyUnicode_Check(arg) ? PyUnicode_AsUTF8(arg) : NULL;
+  if (value) return true;
+  if (!PyErr_Occurred())
+    PyErr_SetString(PyExc_TypeError,"argument must be str");
+  return false;
+}
+
+bool parseArg(PyObject *arg, float &value)
+{
+  value = (float)(PyFloat_CheckExact(arg) ? PyFloat_AS_DOUBLE(arg) : PyFloat_AsDouble(arg));
+  return !(value == -1.f && PyErr_Occurred());
+}
+
+bool parseArg(PyObject *arg, int &value)
+{
+  const long l = PyLong_AsLong(arg);
+  if (l == -1 && PyErr_Occurred())
+    return false;
+  // 'long' is 64 bits wide on most 64-bit platforms
+  if (l < INT_MIN || l > INT_MAX) {
+    PyErr_SetString(PyExc_OverflowError,"Python int too large to convert to C int");
+    return false;
+  }
+  value = (int)l;
+  return true;
+}
+
+bool parseArg(PyObject *arg, void *&value)
+{
+  value = PyLong_AsVoidPtr(arg);
+  return !(!value && PyErr_Occurred());
+}
+
+template<typename Handle>
+bool parseHandleArg(PyObject *arg, Handle &handle)
+{
+  return parseHandle(arg,&handle) != 0;
+}
+
+/*! parses a list of N numbers of a METH_FASTCALL function into
+    'value'; on error sets a TypeError naming the function */
+template<typename T, int N>
+bool parseListArg(const char *function, PyObject *arg, T (&value)[N])
+{
+  try {
+    if (std::is_same<T,float>::value)
+      getFloats(arg,(float*)value,N);
+    else
+      getInts(arg,(int*)value,N);
+    return true;
+  } catch (const std::overflow_error &e) {
+    PyErr_SetString(PyExc_OverflowError,(std::string(function)+": "+e.what()).c_str());
+    return false;
+  } catch (const std::runtime_error &e) {
+    PyErr_SetString(PyExc_TypeError,(std::string(function)+": "+e.what()).c_str());
+    return false;
+  }
+}
+
+/*! affine transform from twelve floats: the three columns of the
+    linear part, then the translation */
+inline osp::affine3f affineFromColumns(const float *xfm)
+{
+  osp::affine3f transform;
+  transform.l.vx = { xfm[0], xfm[1],  xfm[2]  };
+  transform.l.vy = { xfm[3], xfm[4],  xfm[5]  };
+  transform.l.vz = { xfm[6], xfm[7],  xfm[8]  };
+  transform.p    = { xfm[9], xfm[10], xfm[11] };
+  return transform;
+}
+
+/*! affine transform from a row-major 4x4 matrix (bottom row ignored) */
+inline osp::affine3f affineFromMatrix(const float *m)
+{
+  osp::affine3f transform;
+  transform.l.vx = { m[0], m[4], m[8]  };
+  transform.l.vy = { m[1], m[5], m[9]  };
+  transform.l.vz = { m[2], m[6], m[10] };
+  transform.p    = { m[3], m[7], m[11] };
+  return transform;
+}
+
+
+
+// ##################################################################
+// buffer-protocol ('zero-copy') data input
+// ##################################################################
+
+/*! description of a data format we accept in ospNewData: which
+    ospray type it maps to, what scalar type each item is made of (in
+    python's struct module notation: 'b'/'B'=int8/uint8,
+    'h'/'H'=int16/uint16, 'i'/'I'=int32/uint32, 'q'/'Q'=int64/uint64,
+    'f'=float32, 'd'=float64, 'P'=pointer-sized object handle), and
+    how many of those scalars make up one item */
+struct DataFormat {
+  const char  *name;
+  const char  *ospName;
+  OSPDataType  type;
+  char         scalar;
+  int          numScalars;
+};
+
+#define DATA_FORMAT(name,type,scalar,numScalars) { name, #type, type, scalar, numScalars }
+
+static const DataFormat dataFormats[] = {
+  DATA_FORMAT("char",   OSP_CHAR,   'b',1),
+  DATA_FORMAT("uchar",  OSP_UCHAR,  'B',1),
+  DATA_FORMAT("uchar2", OSP_UCHAR2, 'B',2),
+  DATA_FORMAT("uchar3", OSP_UCHAR3, 'B',3),
+  DATA_FORMAT("uchar4", OSP_UCHAR4, 'B',4),
+  DATA_FORMAT("short",  OSP_SHORT,  'h',1),
+  DATA_FORMAT("ushort", OSP_USHORT, 'H',1),
+  DATA_FORMAT("int",    OSP_INT,    'i',1),
+  DATA_FORMAT("int2",   OSP_INT2,   'i',2),
+  DATA_FORMAT("int3",   OSP_INT3,   'i',3),
+  DATA_FORMAT("int4",   OSP_INT4,   'i',4),
+  DATA_FORMAT("uint",   OSP_UINT,   'I',1),
+  DATA_FORMAT("uint2",  OSP_UINT2,  'I',2),
+  DATA_FORMAT("uint3",  OSP_UINT3,  'I',3),
+  DATA_FORMAT("uint4",  OSP_UINT4,  'I',4),
+  DATA_FORMAT("long",   OSP_LONG,   'q',1),
+  DATA_FORMAT("long2",  OSP_LONG2,  'q',2),
+  DATA_FORMAT("long3",  OSP_LONG3,  'q',3),
+  DATA_FORMAT("long4",  OSP_LONG4,  'q',4),
+  DATA_FORMAT("ulong",  OSP_ULONG,  'Q',1),
+  DATA_FORMAT("ulong2", OSP_ULONG2, 'Q',2),
+  DATA_FORMAT("ulong3", OSP_ULONG3, 'Q',3),
+  DATA_FORMAT("ulong4", OSP_ULONG4, 'Q',4),
+  DATA_FORMAT("float",  OSP_FLOAT,  'f',1),
+  DATA_FORMAT("float2", OSP_FLOAT2, 'f',2),
+  DATA_FORMAT("float3", OSP_FLOAT3, 'f',3),
+  DATA_FORMAT("float4", OSP_FLOAT4, 'f',4),
+  DATA_FORMAT("float3a",OSP_FLOAT3A,'f',4),
+  DATA_FORMAT("double", OSP_DOUBLE, 'd',1),
+  // arrays of object handles
+  DATA_FORMAT("object",           OSP_OBJECT,            'P',1),
+  DATA_FORMAT("camera",           OSP_CAMERA,            'P',1),
+  DATA_FORMAT("data",             OSP_DATA,              'P',1),
+  DATA_FORMAT("framebuffer",      OSP_FRAMEBUFFER,       'P',1),
+  DATA_FORMAT("geometry",         OSP_GEOMETRY,          'P',1),
+  DATA_FORMAT("light",            OSP_LIGHT,             'P',1),
+  DATA_FORMAT("material",         OSP_MATERIAL,          'P',1),
+  DATA_FORMAT("model",            OSP_MODEL,             'P',1),
+  DATA_FORMAT("renderer",         OSP_RENDERER,          'P',1),
+  DATA_FORMAT("texture",          OSP_TEXTURE,           'P',1),
+  DATA_FORMAT("transfer_function",OSP_TRANSFER_FUNCTION, 'P',1),
+  DATA_FORMAT("volume",           OSP_VOLUME,            'P',1),
+};
+
+#undef DATA_FORMAT
+
+/*! look up given format string (either short form such as 'float3a',
+    or the ospray enum name such as 'OSP_FLOAT3A') */
+const DataFormat *findDataFormat(const std::string &format)
+{
+  for (auto &df : dataFormats)
+    if (format == df.name || format == df.ospName)
+      return &df;
+  return nullptr;
+}
+
+/*! size of one scalar of the given data format, in bytes */
+size_t scalarSize(const DataFormat &df)
+{
+  switch (df.scalar) {
+  case 'b': case 'B': return 1;
+  case 'h': case 'H': return 2;
+  case 'i': case 'I': return 4;
+  case 'q': case 'Q': return 8;
+  case 'f': return sizeof(float);
+  case 'd': return sizeof(double);
+  default : return sizeof(void*);
+  }
+}
+
+/*! checks whether the (struct-module style) format of given buffer
+    view matches the scalar type of given data format. Untyped byte
+    buffers (bytes, bytearray, raw memoryviews) always match - for
+    those we can only check the total size. Integers of either
+    signedness match, as long as they have the right size */
+bool bufferMatchesFormat(const Py_buffer &view, const DataFormat &df)
+{
+  const char *fmt = view.format ? view.format : "B";
+  if (*fmt == '@' || *fmt == '=' || *fmt == '<') ++fmt;
+  if (!strcmp(fmt,"B") || !strcmp(fmt,"b") || !strcmp(fmt,"c"))
+    return true;
+  if (fmt[0] == 0 || fmt[1] != 0 || (size_t)view.itemsize != scalarSize(df))
+    return false;
+  switch (df.scalar) {
+  case 'f': 
+  case 'd': return fmt[0] == df.scalar;
+  case 'P': return strchr("lLqQnNP",fmt[0]) != nullptr;
+  default : return strchr("bBhHiIlLqQnN",fmt[0]) != nullptr;
+  }
+}
+
+/*! memory shared with an ospray data object: either the buffer view
+    of a python object, or a copy we own (converted lists, gathered
+    strided buffers). Kept for as long as ospray may use the data
+    object - after its handle got released, until nothing that uses it
+    is left (see Dependencies) - or until ospShutdown */
+struct SharedDataMemory {
+  Py_buffer                  *view { nullptr };
+  std::vector<unsigned char>  bytes;
+  const DataFormat           *format { nullptr };
+  size_t                      numItems { 0 };
+
+  /*! the memory ospray reads the items from */
+  unsigned char *items()
+  { return view ? (unsigned char *)view->buf : bytes.data(); }
+
+  void releaseView()
+  {
+    if (!view) return;
+    // without ospShutdown, what's still shared at exit only gets
+    // destroyed after python is gone; the view is moot by then
+    if (Py_IsInitialized())
+      PyBuffer_Release(view);
+    delete view;
+    view = nullptr;
+  }
+  ~SharedDataMemory() { releaseView(); }
+};
+
+static std::map<OSPObject,std::shared_ptr<SharedDataMemory>> sharedDataMemory;
+
+/*! returns the items of a data array from the memory of an object that
+    supports the buffer protocol (numpy arrays, memoryview, bytes,
+    array.array, ...). Contiguous buffers get used in place; strided
+    ones (slices, fields of structured arrays) get gathered into
+    'memory.bytes'. With a non-zero byteStride, the buffer is instead
+    taken as raw bytes with one item every byteStride bytes, starting
+    at byteOffset - e.g., the normals in an interleaved vertex buffer.
+    Throws if the buffer doesn't match what the format expects */
+const void *bufferItems(int numItems, const DataFormat &df, PyObject *values,
+                        size_t byteStride, size_t byteOffset,
+                        SharedDataMemory &memory)
+{
+  memory.view = new Py_buffer;
+  if (PyObject_GetBuffer(values,memory.view,PyBUF_RECORDS_RO) != 0) {
+    delete memory.view;
+    memory.view = nullptr;
+    PyErr_Clear();
+    throw std::runtime_error("ospNewData: cannot access data buffer");
+  }
+  const Py_buffer &view = *memory.view;
+  const size_t itemSize = df.numScalars*scalarSize(df);
+
+  if (byteStride) {
+    if (!PyBuffer_IsContiguous(&view,'A'))
+      throw std::runtime_error("ospNewData: stride and offset need a contiguous buffer");
+    const size_t needed = numItems ? byteOffset+(numItems-1)*byteStride+itemSize : 0;
+    if (needed > (size_t)view.len)
+      throw std::runtime_error("ospNewData: buffer has "+std::to_string(view.len)
+                               +" bytes, but "+std::to_string(numItems)
+                               +" items at given stride and offset need "
+                               +std::to_string(needed));
+    memory.bytes.resize(numItems*itemSize);
+    const unsigned char *in = (const unsigned char *)view.buf+byteOffset;
+    parallelForRows(numItems,1<<14,[&](int begin, int end) {
+        for (int i = begin; i < end; i++)
+          memcpy(&memory.bytes[i*itemSize],in+i*byteStride,itemSize);
+      });
+    countBytes(memory.bytes.size());
+    memory.releaseView();
+    return memory.bytes.data();
+  }
+
+  std::string error;
+  if (!bufferMatchesFormat(view,df))
+    error = std::string("buffer element type '")+(view.format?view.format:"?")
+      +"' does not match data format '"+df.name+"'";
+  else if ((size_t)view.len != numItems*itemSize)
+    error = "buffer has "+std::to_string(view.len)+" bytes, but "
+      +std::to_string(numItems)+" items of format '"+df.name+"' need "
+      +std::to_string(numItems*itemSize);
+  else if (view.ndim > 1 && view.shape
+           && view.shape[view.ndim-1]*view.itemsize != (Py_ssize_t)itemSize)
+    error = "innermost buffer dimension does not match the "
+      +std::to_string(df.numScalars)+" components of format '"+df.name+"'";
+  if (!error.empty())
+    throw std::runtime_error("ospNewData: "+error);
+
+  if (PyBuffer_IsContiguous(&view,'C'))
+    return view.buf;
+
+  // strided: gather into our own, contiguous copy
+  memory.bytes.resize(view.len);
+  if (PyBuffer_ToContiguous(memory.bytes.data(),memory.view,view.len,'C') < 0) {
+    PyErr_Clear();
+    throw std::runtime_error("ospNewData: cannot gather strided buffer");
+  }
+  countBytes(memory.bytes.size());
+  memory.releaseView();
+  return memory.bytes.data();
+}
+
+/*! release the memory (if any) that is shared with the given data
+    object, once ospray is done with it */
+void releaseSharedDataBuffer(OSPObject object)
+{
+  sharedDataMemory.erase(object);
+}
+
+/*! converts a sequence into an array of given scalar type */
+template<typename T, typename Convert>
+void convertSequenceTo(PyObject *valuesList, std::vector<unsigned char> &bytes,
+                       Convert convert)
+{
+  FastSequence seq(valuesList);
+  const size_t numValues = seq.size();
+  bytes.resize(numValues*sizeof(T));
+  T *values = (T *)bytes.data();
+  for (size_t i = 0; i < numValues; i++)
+    values[i] = (T)convert(seq[i]);
+  countBytes(bytes.size());
+}
+
+/*! an int for an integer scalar of type T; narrower types take any
+    value that fits either their signed or unsigned range (i.e., any
+    bit pattern), so e.g. -1 is fine for a uint32. Throws otherwise */
+template<typename T>
+long long getScalarInt(PyObject *iter)
+{
+  const long long value = getLongLong(iter);
+  typedef typename std::make_signed<T>::type   Signed;
+  typedef typename std::make_unsigned<T>::type Unsigned;
+  if (sizeof(T) < sizeof(long long)
+      && (value < (long long)std::numeric_limits<Signed>::min()
+          || value > (long long)std::numeric_limits<Unsigned>::max()))
+    throw std::overflow_error("value "+std::to_string(value)+" does not fit in "
+                             +std::to_string(8*sizeof(T))+" bits");
+  return value;
+}
+
+/*! converts a list of python numbers (or objects, for handle formats)
+    to the given data format's scalar type */
+void convertList(PyObject *values, const DataFormat &df, std::vector<unsigned char> &bytes)
+{
+  switch (df.scalar) {
+  case 'b': convertSequenceTo<int8_t>  (values,bytes,getScalarInt<int8_t>);   break;
+  case 'B': convertSequenceTo<uint8_t> (values,bytes,getScalarInt<uint8_t>);  break;
+  case 'h': convertSequenceTo<int16_t> (values,bytes,getScalarInt<int16_t>);  break;
+  case 'H': convertSequenceTo<uint16_t>(values,bytes,getScalarInt<uint16_t>); break;
+  case 'i': convertSequenceTo<int32_t> (values,bytes,getScalarInt<int32_t>);  break;
+  case 'I': convertSequenceTo<uint32_t>(values,bytes,getScalarInt<uint32_t>); break;
+  case 'q': convertSequenceTo<int64_t> (values,bytes,getScalarInt<int64_t>);  break;
+  case 'Q': convertSequenceTo<uint64_t>(values,bytes,getScalarInt<uint64_t>); break;
+  case 'f': convertSequenceTo<float>   (values,bytes,getFloat);               break;
+  case 'd': convertSequenceTo<double>  (values,bytes,getDouble);              break;
+  default : convertSequenceTo<OSPObject>(values,bytes,getHandle);             break;
+  }
+}
+
+/*! the data format for given format string; throws if unknown */
+const DataFormat &dataFormat(const std::string &format)
+{
+  const DataFormat *df = findDataFormat(format);
+  if (!df)
+    throw std::runtime_error("unknown or not implemeneted format type '"
+                             +format+"' is ospNewData");
+  return *df;
+}
+
+/*! checks that the handles of an object array, given as raw
+    (possibly unaligned) pointer-sized integers, are all handles of
+    live objects - as getHandle does for ints - so a stray number in a
+    buffer raises rather than crashing ospray */
+void checkHandles(const void *items, size_t numItems)
+{
+  for (size_t i = 0; i < numItems; i++) {
+    OSPObject handle;
+    memcpy(&handle,(const unsigned char *)items+i*sizeof(handle),sizeof(handle));
+    if (!liveObjects.count(handle))
+      throw std::runtime_error("ospNewData: item "+std::to_string(i)
+                               +" is not the handle of a live object");
+  }
+}
+
+/*! the items of a data array, from either a buffer-protocol object
+    (see bufferItems) or a list of numbers (converted into
+    'memory.bytes'). Throws on invalid input */
+const void *dataItems(int numItems, const DataFormat &df, PyObject *values,
+                      size_t byteStride, size_t byteOffset,
+                      SharedDataMemory &memory)
+{
+  if (numItems < 0)
+    throw std::runtime_error("ospNewData: negative number of items");
+  if (PyObject_CheckBuffer(values)) {
+    const void *items = bufferItems(numItems,df,values,byteStride,byteOffset,memory);
+    if (df.scalar == 'P')
+      checkHandles(items,numItems);
+    return items;
+  }
+
+  if (byteStride || byteOffset)
+    throw std::runtime_error("ospNewData: stride and offset need a buffer object");
+  convertList(values,df,memory.bytes);
+  const size_t numValues = memory.bytes.size()/scalarSize(df);
+  if (numValues != (size_t)numItems*df.numScalars)
+    throw std::runtime_error("ospNewData: list has "+std::to_string(numValues)
+                             +" values, but "+std::to_string(numItems)+" items of format '"
+                             +df.name+"' need "+std::to_string(numItems*df.numScalars));
+  return memory.bytes.data();
+}
+
+/*! records a new data object while ospRecordScene is on; see scene
+    recording, below */
+void recordData(OSPData data, const DataFormat &df, size_t numItems, const void *items,
+                std::shared_ptr<SharedDataMemory> memory, bool shared);
+
+/*! ospray holds on to the objects in an object array */
+void addElementDependencies(OSPData data, const DataFormat &df, size_t numItems,
+                            const void *items);
+
+/*! create a data array of given format from either a buffer-protocol
+    object or a list of numbers (converted). By default (flags = 0)
+    ospray makes its own copy right away. With flags =
+    OSP_DATA_SHARED_BUFFER it uses the memory in place: the python
+    object's buffer, or our converted/gathered copy, which stay alive
+    for as long as ospray may use the data object (see
+    SharedDataMemory). Throws on invalid input */
+OSPData newData(int numItems, const std::string &format, PyObject *values,
+                uint32_t flags = 0,
+                size_t byteStride = 0, size_t byteOffset = 0)
+{
+  const DataFormat &df = dataFormat(format);
+  std::shared_ptr<SharedDataMemory> memory(new SharedDataMemory);
+  const void *items = dataItems(numItems,df,values,byteStride,byteOffset,*memory);
+  memory->format   = &df;
+  memory->numItems = numItems;
+
+  OSPData data = ospNewData(numItems,df.type,items,flags);
+  if (!data)
+    return data;
+  const bool shared = flags & OSP_DATA_SHARED_BUFFER;
+  addElementDependencies(data,df,numItems,items);
+  recordData(data,df,numItems,items,memory,shared);
+  if (shared)
+    sharedDataMemory[(OSPObject)data] = std::move(memory);
+  return data;
+}
+
+/*! copies the values of a float32 or float64 buffer (of any shape
+    and strides) into 'floats', and returns the buffer's shape. Throws
+    if it isn't such a buffer */
+std::vector<Py_ssize_t> bufferFloats(PyObject *values, std::vector<float> &floats)
+{
+  Py_buffer view;
+  if (PyObject_GetBuffer(values,&view,PyBUF_RECORDS_RO) != 0) {
+    PyErr_Clear();
+    throw std::runtime_error("expected a buffer (e.g., a numpy array)");
+  }
+  std::unique_ptr<Py_buffer,void(*)(Py_buffer*)> release(&view,PyBuffer_Release);
+
+  const char *fmt = view.format ? view.format : "B";
+  if (*fmt == '@' || *fmt == '=' || *fmt == '<') ++fmt;
+  const bool isDouble = !strcmp(fmt,"d");
+  if ((!isDouble && strcmp(fmt,"f")) || view.itemsize != (isDouble ? 8 : 4))
+    throw std::runtime_error("expected float32 or float64 values");
+
+  std::vector<unsigned char> gathered;
+  const void *buf = view.buf;
+  if (!PyBuffer_IsContiguous(&view,'C')) {
+    gathered.resize(view.len);
+    if (PyBuffer_ToContiguous(gathered.data(),&view,view.len,'C') < 0) {
+      PyErr_Clear();
+      throw std::runtime_error("cannot gather strided buffer");
+    }
+    buf = gathered.data();
+  }
+  const size_t numValues = view.len/view.itemsize;
+  if (isDouble)
+    floats.assign((const double *)buf,(const double *)buf+numValues);
+  else
+    floats.assign((const float *)buf,(const float *)buf+numValues);
+  if (view.ndim == 0)
+    return { (Py_ssize_t)numValues };
+  return std::vector<Py_ssize_t>(view.shape,view.shape+view.ndim);
+}
+
+/*! reads an array of affine transforms from a float32 or float64
+    buffer, shaped either (N,12) - twelve values as for ospNewInstance
+    - or (N,4,4)/(N,16), row-major matrices as numpy has them. A flat
+    buffer of 12*N values counts as (N,12). Throws on mismatch */
+std::vector<osp::affine3f> bufferTransforms(PyObject *values)
+{
+  std::vector<float> floats;
+  const std::vector<Py_ssize_t> shape = bufferFloats(values,floats);
+  const size_t ndim = shape.size();
+  const bool isMatrix
+    = (ndim >= 2 && shape[ndim-1] == 4 && shape[ndim-2] == 4)
+    || (ndim >= 2 && shape[ndim-1] == 16);
+  const size_t stride = isMatrix ? 16 : 12;
+  if ((!isMatrix && ndim >= 2 && shape[ndim-1] != 12) || floats.size() % stride)
+    throw std::runtime_error("expected shape (N,12) or (N,4,4)");
+
+  std::vector<osp::affine3f> transforms(floats.size()/stride);
+  parallelForRows((int)transforms.size(),1<<14,[&](int begin, int end) {
+      for (int i = begin; i < end; i++) {
+        const float *m = &floats[i*stride];
+        transforms[i] = isMatrix ? affineFromMatrix(m) : affineFromColumns(m);
+      }
+    });
+  return transforms;
+}
+
+
+
+// ##################################################################
+// content-addressed data cache
+// ##################################################################
+
+/*! 64-bit finalizer of MurmurHash3 */
+inline uint64_t mixBits(uint64_t h)
+{
+  h ^= h >> 33; h *= 0xff51afd7ed558ccdull;
+  h ^= h >> 33; h *= 0xc4ceb9fe1a85ec53ull;
+  h ^= h >> 33;
+  return h;
+}
+
+inline uint64_t rotateLeft(uint64_t x, int r) { return (x << r) | (x >> (64-r)); }
+
+/*! fast non-cryptographic hash of a block of bytes: two lanes of
+    multiply-rotate mixing over 16 bytes at a time (murmur style) */
+uint64_t hashBlock(const unsigned char *bytes, size_t numBytes, uint64_t seed)
+{
+  const uint64_t k1 = 0x87c37b91114253d5ull, k2 = 0x4cf5ad432745937full;
+  uint64_t a = seed ^ numBytes, b = ~seed;
+  size_t i = 0;
+  for (; i+16 <= numBytes; i += 16) {
+    uint64_t w0, w1;
+    memcpy(&w0,bytes+i,8);
+    memcpy(&w1,bytes+i+8,8);
+    a = rotateLeft(a ^ (w0*k1),31)*k2 + w1;
+    b = rotateLeft(b ^ (w1*k2),33)*k1 + w0;
+  }
+  uint64_t tail[2] = { 0, 0 };
+  memcpy(tail,bytes+i,numBytes-i);
+  a = rotateLeft(a ^ (tail[0]*k1),31)*k2 + tail[1];
+  b = rotateLeft(b ^ (tail[1]*k2),33)*k1 + tail[0];
+  return mixBits(a ^ mixBits(b));
+}
+
+/*! hash of a (possibly large) byte array: 1 MB blocks get hashed in
+    parallel, then the block hashes get hashed */
+uint64_t hashBytes(const void *bytes, size_t numBytes, uint64_t seed)
+{
+  const size_t blockSize = 1<<20;
+  if (numBytes <= blockSize)
+    return hashBlock((const unsigned char *)bytes,numBytes,seed);
+  std::vector<uint64_t> blockHashes((numBytes+blockSize-1)/blockSize);
+  parallelForRows((int)blockHashes.size(),1,[&](int begin, int end) {
+      for (int i = begin; i < end; i++)
+        blockHashes[i] = hashBlock((const unsigned char *)bytes+i*blockSize,
+                                   std::min(blockSize,numBytes-i*blockSize),seed);
+    });
+  return hashBlock((const unsigned char *)blockHashes.data(),
+                   blockHashes.size()*sizeof(uint64_t),seed);
+}
+
+/*! opt-in cache of the data objects created by ospNewData, keyed by
+    their content: uploading an array that's identical (same format,
+    count and bytes) to a cached one returns that cached data object
+    again rather than converting and copying it once more. The cache
+    holds one reference to each wrapper, and a private copy of the
+    items that ospray shares - cached arrays are immutable snapshots,
+    whatever happens to the python objects they came from. Entries get
+    evicted least recently used first once the cache holds more than
+    'maxBytes'; the data object itself lives on as long as python (or
+    ospray, e.g. a geometry using it) still references it, and so does
+    its snapshot: that's in sharedDataMemory, which only lets go of it
+    once nothing uses the data anymore. Only used with the GIL held */
+struct DataCache {
+  struct Entry {
+    uint64_t    hash;
+    OSPDataType type;
+    int         numItems;
+    size_t      numBytes;
+    OSPData     data;
+    /*! owned reference to the data's wrapper */
+    PyObject   *wrapper;
+  };
+
+  size_t maxBytes     { 0 };
+  size_t numBytes     { 0 };
+  size_t hits         { 0 };
+  size_t misses       { 0 };
+  size_t evictions    { 0 };
+  size_t bytesSaved   { 0 };
+
+  /*! most recently used first */
+  std::list<Entry> entries;
+  std::unordered_multimap<uint64_t,std::list<Entry>::iterator> byHash;
+  std::map<OSPObject,std::list<Entry>::iterator> byData;
+
+  bool enabled() const { return maxBytes > 0; }
+  bool contains(OSPObject data) const { return byData.count(data) > 0; }
+
+  /*! the data object for given items: the cached one if there is one,
+      else a new one (that gets cached); returns a new reference to
+      its wrapper, or NULL with a python error set */
+  PyObject *newData(int numItems, const DataFormat &df, PyObject *values,
+                    size_t byteStride, size_t byteOffset);
+  void setMaxBytes(size_t maxBytes);
+  void clear() { while (!entries.empty()) evict(std::prev(entries.end())); }
+
+private:
+  void evict(std::list<Entry>::iterator it);
+};
+
+static DataCache dataCache;
+
+PyObject *DataCache::newData(int numItems, const DataFormat &df, PyObject *values,
+                             size_t byteStride, size_t byteOffset)
+{
+  std::shared_ptr<SharedDataMemory> memory(new SharedDataMemory);
+  const void *items = dataItems(numItems,df,values,byteStride,byteOffset,*memory);
+  memory->format   = &df;
+  memory->numItems = numItems;
+  const size_t itemBytes = size_t(numItems)*df.numScalars*scalarSize(df);
+  const uint64_t hash = hashBytes(items,itemBytes,mixBits(uint64_t(df.type) << 32 | numItems));
+
+  // same hash isn't enough: compare the actual bytes, too
+  auto range = byHash.equal_range(hash);
+  for (auto h = range.first; h != range.second; ++h) {
+    auto it = h->second;
+    if (it->type != df.type || it->numItems != numItems)
+      continue;
+    const SharedDataMemory &cached = *sharedDataMemory[(OSPObject)it->data];
+    if (memcmp(cached.bytes.data(),items,itemBytes) != 0)
+      continue;
+    entries.splice(entries.begin(),entries,it);
+    hits++;
+    bytesSaved += itemBytes;
+    Py_INCREF(it->wrapper);
+    return it->wrapper;
+  }
+
+  misses++;
+  if (memory->bytes.empty()) {
+    // items are still the python object's memory; take a snapshot
+    memory->bytes.assign((const unsigned char *)items,(const unsigned char *)items+itemBytes);
+    memory->releaseView();
+    countBytes(itemBytes);
+  }
+  OSPData data = ospNewData(numItems,df.type,memory->bytes.data(),OSP_DATA_SHARED_BUFFER);
+  if (!data) {
+    PyErr_SetString(PyExc_RuntimeError,"ospray could not create object");
+    return NULL;
+  }
+  recordData(data,df,numItems,memory->bytes.data(),memory,true);
+  sharedDataMemory[(OSPObject)data] = std::move(memory);
+  PyObject *wrapper = wrapObject(data,&DataType);
+  if (!wrapper || itemBytes > maxBytes)
+    return wrapper;
+
+  Py_INCREF(wrapper);
+  entries.push_front({ hash, df.type, numItems, itemBytes, data, wrapper });
+  byHash.insert({ hash, entries.begin() });
+  byData[(OSPObject)data] = entries.begin();
+  numBytes += itemBytes;
+  while (numBytes > maxBytes)
+    evict(std::prev(entries.end()));
+  return wrapper;
+}
+
+void DataCache::evict(std::list<Entry>::iterator it)
+{
+  auto range = byHash.equal_range(it->hash);
+  for (auto h = range.first; h != range.second; ++h)
+    if (h->second == it) {
+      byHash.erase(h);
+      break;
+    }
+  byData.erase((OSPObject)it->data);
+  numBytes -= it->numBytes;
+  evictions++;
+  PyObject *wrapper = it->wrapper;
+  entries.erase(it);
+  // may be the last reference, which queues the release; the snapshot
+  // stays until ospray is done with the data, too (see releaseObject)
+  Py_DECREF(wrapper);
+}
+
+void DataCache::setMaxBytes(size_t newMaxBytes)
+{
+  maxBytes = newMaxBytes;
+  while (numBytes > maxBytes)
+    evict(std::prev(entries.end()));
+}
+
+
+
+// ##################################################################
+// scene recording
+// ##################################################################
+
+/*! a run of bytes, and the owner (that we share) keeping it alive */
+struct SceneBlob {
+  SceneBlob() {}
+  SceneBlob(const void *bytes, size_t numBytes, std::shared_ptr<void> owner = nullptr)
+    : bytes(bytes), numBytes(numBytes), owner(std::move(owner))
+  {}
+
+  const void           *bytes    { nullptr };
+  size_t                numBytes { 0 };
+  std::shared_ptr<void> owner;
+};
+
+struct SceneObject;
+
+/*! a parameter of a recorded object, as it was set last */
+struct SceneParam {
+  std::string                  name;
+  /*! 'i' or 'f' (with 'count' values), 'b', 's', or 'o' (object) */
+  char                         type  { 'i' };
+  int                          count { 1 };
+  int                          ints[4];
+  float                        floats[4];
+  std::string                  string;
+  std::shared_ptr<SceneObject> object;
+};
+
+/*! what ospSaveScene needs to re-create an object that was created
+    through these bindings while recording (see ospRecordScene).
+    Records reference each other the way ospray's objects do, so a
+    record lives on after its handle got released, for as long as
+    anything recorded uses it */
+struct SceneObject {
+  enum Kind : uint32_t {
+    CAMERA, RENDERER, LIGHT, MODEL, GEOMETRY, DATA, VOLUME, TRANSFER_FUNCTION,
+    /*! a geometry made by ospNewInstance */
+    INSTANCE,
+    /*! the instances ospAddInstances added to a model (no handle) */
+    INSTANCES,
+    NUM_KINDS
+  };
+
+  SceneObject(Kind kind, const std::string &type) : kind(kind), type(type) {}
+
+  Kind                    kind;
+  std::string             type;
+  bool                    committed { false };
+  /*! why ospSaveScene can't save the object, if it can't */
+  std::string             unsavable;
+  std::vector<SceneParam> params;
+  /*! models: the geometries, volumes and instances added to them;
+      instances: the instanced model */
+  std::vector<std::shared_ptr<SceneObject>> members;
+  /*! instances: their osp::affine3f transforms */
+  SceneBlob               transforms;
+  /*! data: format and items - or for object arrays, the objects */
+  const DataFormat       *format   { nullptr };
+  size_t                  numItems { 0 };
+  SceneBlob               items;
+  std::vector<std::shared_ptr<SceneObject>> elements;
+  /*! volumes: the voxel regions set, in order */
+  struct Region {
+    osp::vec3i start, size;
+    SceneBlob  voxels;
+  };
+  std::vector<Region>     regions;
+
+  /*! the parameter of given name, to be (re-)set */
+  SceneParam &param(const std::string &name)
+  {
+    for (auto &p : params)
+      if (p.name == name) {
+        p.object.reset();
+        return p;
+      }
+    params.push_back(SceneParam());
+    params.back().name = name;
+    return params.back();
+  }
+};
+
+static bool sceneRecording = false;
+static std::map<OSPObject,std::shared_ptr<SceneObject>> sceneObjects;
+
+struct MappedFile;
+
+/*! the memory-mapped scene file that each object made by
+    ospLoadScene shares its arrays with; kept until ospray is done with
+    the object (see forgetObject) */
+static std::map<OSPObject,std::shared_ptr<MappedFile>> sceneFiles;
+
+/*! the record of 'object', if we're recording and it has one */
+std::shared_ptr<SceneObject> sceneRecord(OSPObject object)
+{
+  if (!sceneRecording) return nullptr;
+  auto it = sceneObjects.find(object);
+  return it == sceneObjects.end() ? nullptr : it->second;
+}
+
+void recordNew(OSPObject object, SceneObject::Kind kind, const std::string &type)
+{
+  if (sceneRecording && object)
+    sceneObjects[object] = std::make_shared<SceneObject>(kind,type);
+}
+
+void recordCommit(OSPObject object)
+{
+  if (!sceneRecording) return;
+  if (auto record = sceneRecord(object))
+    record->committed = true;
+}
+
+void recordParam(OSPObject object, const char *name, const int *values, int count)
+{
+  if (!sceneRecording) return;
+  if (auto record = sceneRecord(object)) {
+    SceneParam &p = record->param(name);
+    p.type  = 'i';
+    p.count = count;
+    std::copy(values,values+count,p.ints);
+  }
+}
+
+void recordParam(OSPObject object, const char *name, const float *values, int count)
+{
+  if (!sceneRecording) return;
+  if (auto record = sceneRecord(object)) {
+    SceneParam &p = record->param(name);
+    p.type  = 'f';
+    p.count = count;
+    std::copy(values,values+count,p.floats);
+  }
+}
+
+void recordParam(OSPObject object, const char *name, bool value)
+{
+  if (!sceneRecording) return;
+  if (auto record = sceneRecord(object)) {
+    SceneParam &p = record->param(name);
+    p.type    = 'b';
+    p.ints[0] = value;
+  }
+}
+
+void recordParam(OSPObject object, const char *name, const std::string &value)
+{
+  if (!sceneRecording) return;
+  if (auto record = sceneRecord(object)) {
+    SceneParam &p = record->param(name);
+    p.type   = 's';
+    p.string = value;
+  }
+}
+
+/*! an object (or data) parameter */
+void recordObjectParam(OSPObject object, const char *name, OSPObject value)
+{
+  if (!sceneRecording) return;
+  if (auto record = sceneRecord(object)) {
+    SceneParam &p = record->param(name);
+    p.type   = 'o';
+    p.object = sceneRecord(value);
+    if (!p.object)
+      record->unsavable = std::string("parameter '")+name+"' is an object that was not recorded";
+  }
+}
+
+void recordUnsavable(OSPObject object, const std::string &why)
+{
+  if (!sceneRecording) return;
+  if (auto record = sceneRecord(object))
+    record->unsavable = why;
+}
+
+void recordMember(OSPObject model, OSPObject member)
+{
+  if (!sceneRecording) return;
+  if (auto record = sceneRecord(model)) {
+    auto memberRecord = sceneRecord(member);
+    if (memberRecord)
+      record->members.push_back(memberRecord);
+    else
+      record->unsavable = "a geometry or volume added to it was not recorded";
+  }
+}
+
+/*! a new data object, whose items are in 'memory': shared with
+    ospray, or what ospray made its own copy from (flags = 0) */
+void recordData(OSPData data, const DataFormat &df, size_t numItems, const void *items,
+                std::shared_ptr<SharedDataMemory> memory, bool shared)
+{
+  if (!sceneRecording || !data) return;
+  auto record = std::make_shared<SceneObject>(SceneObject::DATA,df.name);
+  record->format   = &df;
+  record->numItems = numItems;
+  if (df.scalar == 'P') {
+    for (size_t i = 0; i < numItems; i++) {
+      auto element = sceneRecord(((const OSPObject *)items)[i]);
+      if (!element)
+        record->unsavable = "it holds objects that were not recorded";
+      record->elements.push_back(element);
+    }
+  } else {
+    const size_t numBytes = numItems*df.numScalars*scalarSize(df);
+    if (!shared && memory->view) {
+      // don't keep the python object around; we only need the values
+      memory->bytes.assign((const unsigned char *)items,(const unsigned char *)items+numBytes);
+      memory->releaseView();
+      items = memory->bytes.data();
+    }
+    record->items = SceneBlob(items,numBytes,std::move(memory));
+  }
+  sceneObjects[(OSPObject)data] = record;
+}
+
+void recordNewInstance(OSPObject instance, OSPObject model, const osp::affine3f &transform)
+{
+  if (!sceneRecording || !instance) return;
+  auto record = std::make_shared<SceneObject>(SceneObject::INSTANCE,"instance");
+  auto modelRecord = sceneRecord(model);
+  if (!modelRecord)
+    record->unsavable = "the instanced model was not recorded";
+  record->members.push_back(modelRecord);
+  auto owner = std::make_shared<osp::affine3f>(transform);
+  record->transforms = SceneBlob(owner.get(),sizeof(osp::affine3f),owner);
+  sceneObjects[instance] = record;
+}
+
+void recordInstances(OSPObject model, OSPObject prototype, std::vector<osp::affine3f> &&transforms)
+{
+  if (!sceneRecording || transforms.empty()) return;
+  auto modelRecord = sceneRecord(model);
+  if (!modelRecord) return;
+  auto record = std::make_shared<SceneObject>(SceneObject::INSTANCES,"instances");
+  auto prototypeRecord = sceneRecord(prototype);
+  if (!prototypeRecord)
+    modelRecord->unsavable = "the model it instances was not recorded";
+  record->members.push_back(prototypeRecord);
+  auto owner = std::make_shared<std::vector<osp::affine3f>>(std::move(transforms));
+  record->transforms = SceneBlob(owner->data(),owner->size()*sizeof(osp::affine3f),owner);
+  modelRecord->members.push_back(record);
+}
+
+void recordRegion(OSPObject volume, const osp::vec3i &start, const osp::vec3i &size,
+                  SceneBlob &&voxels)
+{
+  if (!sceneRecording) return;
+  if (auto record = sceneRecord(volume))
+    record->regions.push_back({ start, size, std::move(voxels) });
+}
+
+/*! forget the handle of a released object (its record lives on in
+    the records of whatever uses it) */
+void releaseSceneObject(OSPObject object)
+{
+  sceneObjects.erase(object);
+}
+
+
+
+// ##################################################################
+// frame buffer mapping
+// ##################################################################
+
+/*! what we remember about each frame buffer created through these
+    bindings (ospray itself doesn't let us query that) */
+struct FrameBufferInfo {
+  osp::vec2i           size;
+  OSPFrameBufferFormat format;
+  /*! the OSP_FB_xyz channels it was created with */
+  uint32_t             channels;
+};
+
+static std::map<OSPObject,FrameBufferInfo> frameBufferInfos;
+
+/*! a mapped channel of a frame buffer, exposed to python as a
+    read-only buffer-protocol object (i.e., numpy.asarray() or
+    memoryview() of it do not copy any pixels). The channel gets
+    unmapped in unmap()/__exit__, or when the object dies */
+struct MappedFrameBuffer {
+  PyObject_HEAD
+  OSPFrameBuffer fb;
+  /*! the frame buffer object we mapped, kept alive while mapped */
+  PyObject      *fbObject;
+  const void    *pixels;
+  int            ndim;
+  Py_ssize_t     shape[3];
+  Py_ssize_t     strides[3];
+  Py_ssize_t     itemsize;
+  char           format[2];
+  int            numExports;
+};
+
+static PyTypeObject MappedFrameBufferType = { PyVarObject_HEAD_INIT(NULL, 0) };
+
+void unmapFrameBuffer(MappedFrameBuffer *self)
+{
+  if (!self->pixels) return;
+  ospUnmapFrameBuffer(self->pixels,self->fb);
+  self->pixels = nullptr;
+  Py_CLEAR(self->fbObject);
+}
+
+static void MappedFrameBuffer_dealloc(MappedFrameBuffer *self)
+{
+  unmapFrameBuffer(self);
+  Py_TYPE(self)->tp_free((PyObject*)self);
+}
+
+static int MappedFrameBuffer_getbuffer(MappedFrameBuffer *self, Py_buffer *view, int flags)
+{
+  if (!self->pixels) {
+    PyErr_SetString(PyExc_BufferError,"frame buffer is no longer mapped");
+    return -1;
+  }
+  if (flags & PyBUF_WRITABLE) {
+    PyErr_SetString(PyExc_BufferError,"mapped frame buffer is read-only");
+    return -1;
+  }
+  view->obj        = (PyObject*)self;
+  view->buf        = (void*)self->pixels;
+  view->itemsize   = self->itemsize;
+  view->len        = self->itemsize;
+  for (int i=0;i<self->ndim;i++) view->len *= self->shape[i];
+  view->readonly   = 1;
+  view->ndim       = self->ndim;
+  view->format     = (flags & PyBUF_FORMAT) ? self->format : NULL;
+  view->shape      = (flags & PyBUF_ND) ? self->shape : NULL;
+  view->strides    = ((flags & PyBUF_STRIDES) == PyBUF_STRIDES) ? self->strides : NULL;
+  view->suboffsets = NULL;
+  view->internal   = NULL;
+  Py_INCREF(self);
+  self->numExports++;
+  return 0;
+}
+
+static void MappedFrameBuffer_releasebuffer(MappedFrameBuffer *self, Py_buffer *view)
+{
+  self->numExports--;
+}
+
+static PyObject *MappedFrameBuffer_unmap(MappedFrameBuffer *self, PyObject *args)
+{
+  if (self->numExports > 0) {
+    PyErr_SetString(PyExc_BufferError,
+                    "cannot unmap frame buffer while views of it still exist");
+    return NULL;
+  }
+  unmapFrameBuffer(self);
+  Py_INCREF(Py_None);
+  return Py_None;
+}
+
+static PyObject *MappedFrameBuffer_enter(MappedFrameBuffer *self, PyObject *args)
+{
+  Py_INCREF(self);
+  return (PyObject*)self;
+}
+
+static PyBufferProcs MappedFrameBuffer_asBuffer;
+
+static PyMethodDef MappedFrameBuffer_methods[] = {
+  {"unmap",    (PyCFunction)MappedFrameBuffer_unmap, METH_NOARGS,  "unmap the frame buffer channel."},
+  {"__enter__",(PyCFunction)MappedFrameBuffer_enter, METH_NOARGS,  "context manager entry; returns self."},
+  {"__exit__", (PyCFunction)MappedFrameBuffer_unmap, METH_VARARGS, "context manager exit; unmaps."},
+  {NULL, NULL, 0, NULL}
+};
+
+/*! set up the MappedFrameBuffer type; to be called during module init */
+int initMappedFrameBufferType()
+{
+  MappedFrameBuffer_asBuffer.bf_getbuffer
+    = (getbufferproc)MappedFrameBuffer_getbuffer;
+  MappedFrameBuffer_asBuffer.bf_releasebuffer
+    = (releasebufferproc)MappedFrameBuffer_releasebuffer;
+
+  PyTypeObject &t = MappedFrameBufferType;
+  t.tp_name      = "ospray.MappedFrameBuffer";
+  t.tp_basicsize = sizeof(MappedFrameBuffer);
+  t.tp_dealloc   = (destructor)MappedFrameBuffer_dealloc;
+  t.tp_as_buffer = &MappedFrameBuffer_asBuffer;
+  t.tp_flags     = Py_TPFLAGS_DEFAULT;
+  t.tp_doc       = "mapped frame buffer channel (read-only buffer protocol object).";
+  t.tp_methods   = MappedFrameBuffer_methods;
+  return PyType_Ready(&t);
+}
+
+
+
+// ##################################################################
+// shared-memory frame rings
+// ##################################################################
+
+/*! a frame ring in shared memory (native byte order) is one
+    FrameRingHeader, followed by 'numSlots' slots of 'slotBytes'
+    bytes each, starting at byte 'firstSlot'. Each slot is a
+    FrameSlotHeader, with the frame's pixels at byte 'pixelOffset' of
+    the slot: the color channel as ospMapFrameBuffer has it (first
+    row at the bottom).
+
+    Frame n goes to slot n % numSlots. While it's being written, that
+    slot's 'sequence' is 2n+1; once complete it's 2n+2, and the
+    header's 'published' becomes n+1. So consumers poll 'published',
+    and a frame they read (or used in place) is intact if its slot's
+    'sequence' was 2n+2 both before and after - no locks involved.
+    See samples/frameRingReader.py */
+struct FrameRingHeader {
+  char                  magic[8];      // "OSPRING"
+  uint32_t              version;
+  uint32_t              numSlots;
+  uint64_t              slotBytes;
+  uint64_t              firstSlot;
+  uint64_t              pixelOffset;
+  int32_t               width, height;
+  uint32_t              format;        // OSPFrameBufferFormat
+  uint32_t              bytesPerPixel;
+  std::atomic<uint64_t> published;
+};
+
+struct FrameSlotHeader {
+  std::atomic<uint64_t> sequence;
+  uint64_t              frameId;
+  uint64_t              timestamp;     // ns on the monotonic clock
+  int32_t               width, height;
+  uint32_t              format;
+  uint32_t              bytesPerPixel;
+  uint64_t              pixelBytes;
+};
+
+static_assert(sizeof(std::atomic<uint64_t>) == 8,
+              "frame rings need plain 64-bit atomics in shared memory");
+
+static const char     frameRingMagic[8] = "OSPRING";
+static const uint32_t frameRingVersion  = 1;
+
+/*! a frame ring we publish frames into; the shared memory object
+    gets unlinked when the ring goes away (consumers that have it
+    mapped keep their mapping) */
+struct FrameRing {
+  std::string      name;
+  FrameRingHeader *header   { nullptr };
+  size_t           numBytes { 0 };
+  /*! one publisher at a time: the caller, or the render worker */
+  std::mutex       mutex;
+
+  FrameRing(const std::string &name, const osp::vec2i &size,
+            OSPFrameBufferFormat format, int numSlots);
+  ~FrameRing();
+
+  FrameSlotHeader *slot(uint64_t frameId) const
+  {
+    return (FrameSlotHeader *)((unsigned char *)header+header->firstSlot
+                               +(frameId % header->numSlots)*header->slotBytes);
+  }
+  bool matches(const FrameBufferInfo &info) const
+  {
+    return info.size.x == header->width && info.size.y == header->height
+      && info.format == (OSPFrameBufferFormat)header->format;
+  }
+  /*! copies the color channel of 'fb' (which matches() the ring)
+      into the next slot; returns its frame id. Call w/o the GIL */
+  uint64_t publish(OSPFrameBuffer fb);
+};
+
+/*! bytes per pixel of a frame buffer format's color channel, 0 if
+    it has none */
+size_t colorBytesPerPixel(OSPFrameBufferFormat format)
+{
+  switch (format) {
+  case OSP_FB_SRGBA:
+  case OSP_FB_RGBA8:   return 4;
+  case OSP_FB_RGBA32F: return 16;
+  default:             return 0;
+  }
+}
+
+FrameRing::FrameRing(const std::string &ringName, const osp::vec2i &size,
+                     OSPFrameBufferFormat format, int numSlots)
+  : name(ringName[0] == '/' ? ringName : "/"+ringName)
+{
+  const size_t bytesPerPixel = colorBytesPerPixel(format);
+  if (!bytesPerPixel)
+    throw std::runtime_error("frame format has no color channel");
+  if (size.x <= 0 || size.y <= 0 || numSlots < 1)
+    throw std::runtime_error("need a positive size and at least one slot");
+  // keep slots (and pixels) cache-line aligned
+  const size_t align       = 64;
+  const size_t pixelOffset = (sizeof(FrameSlotHeader)+align-1)/align*align;
+  const size_t pixelBytes  = size_t(size.x)*size.y*bytesPerPixel;
+  const size_t slotBytes   = (pixelOffset+pixelBytes+align-1)/align*align;
+  const size_t firstSlot   = (sizeof(FrameRingHeader)+align-1)/align*align;
+  numBytes = firstSlot+numSlots*slotBytes;
+#ifdef _WIN32
+  throw std::runtime_error("frame rings need POSIX shared memory");
+#else
+  // never take over an existing name: truncating a live ring would
+  // pull the memory out from under its consumers
+  const int fd = shm_open(name.c_str(),O_CREAT|O_EXCL|O_RDWR,0600);
+  if (fd < 0)
+    throw std::system_error(errno,std::generic_category(),
+                            "cannot create shared memory '"+name+"'");
+  void *mem = MAP_FAILED;
+  if (ftruncate(fd,numBytes) == 0)
+    mem = mmap(nullptr,numBytes,PROT_READ|PROT_WRITE,MAP_SHARED,fd,0);
+  const int error = errno;
+  close(fd);
+  if (mem == MAP_FAILED) {
+    shm_unlink(name.c_str());
+    throw std::runtime_error("cannot map shared memory '"+name+"': "+strerror(error));
+  }
+  header = (FrameRingHeader *)mem;
+#endif
+  // fresh memory is all zeros: no frame published, no slot written
+  new (&header->published) std::atomic<uint64_t>(0);
+  header->version       = frameRingVersion;
+  header->numSlots      = numSlots;
+  header->slotBytes     = slotBytes;
+  header->firstSlot     = firstSlot;
+  header->pixelOffset   = pixelOffset;
+  header->width         = size.x;
+  header->height        = size.y;
+  header->format        = format;
+  header->bytesPerPixel = bytesPerPixel;
+  for (int i = 0; i < numSlots; i++)
+    new (&slot(i)->sequence) std::atomic<uint64_t>(0);
+  // the magic goes last: consumers that see it see everything else
+  std::atomic_thread_fence(std::memory_order_release);
+  memcpy(header->magic,frameRingMagic,sizeof(frameRingMagic));
+}
+
+FrameRing::~FrameRing()
+{
+#ifndef _WIN32
+  if (header) {
+    munmap(header,numBytes);
+    shm_unlink(name.c_str());
+  }
+#endif
+}
+
+uint64_t FrameRing::publish(OSPFrameBuffer fb)
+{
+  std::lock_guard<std::mutex> lock(mutex);
+  const uint64_t frameId = header->published.load(std::memory_order_relaxed);
+  FrameSlotHeader &s = *slot(frameId);
+  s.sequence.store(2*frameId+1,std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_release);
+
+  unsigned char *pixels = (unsigned char *)&s+header->pixelOffset;
+  const size_t rowBytes = size_t(header->width)*header->bytesPerPixel;
+  const unsigned char *mapped = (const unsigned char *)ospMapFrameBuffer(fb,OSP_FB_COLOR);
+  // ~1 MB per block; small frames don't need any extra threads
+  parallelForRows(header->height,std::max<int>(1,(1<<20)/rowBytes),[&](int begin, int end) {
+      memcpy(pixels+begin*rowBytes,mapped+begin*rowBytes,(end-begin)*rowBytes);
+    });
+  ospUnmapFrameBuffer(mapped,fb);
+
+  s.frameId       = frameId;
+  s.timestamp     = std::chrono::duration_cast<std::chrono::nanoseconds>
+    (std::chrono::steady_clock::now().time_since_epoch()).count();
+  s.width         = header->width;
+  s.height        = header->height;
+  s.format        = header->format;
+  s.bytesPerPixel = header->bytesPerPixel;
+  s.pixelBytes    = rowBytes*header->height;
+  s.sequence.store(2*frameId+2,std::memory_order_release);
+  header->published.store(frameId+1,std::memory_order_release);
+  return frameId;
+}
+
+/*! the frame ring each frame buffer publishes its frames to (see
+    ospSetFrameSink) */
+static std::map<OSPObject,std::shared_ptr<FrameRing>> frameSinks;
+
+/*! the frame ring that 'fb' publishes to, if any */
+std::shared_ptr<FrameRing> frameSink(OSPObject fb)
+{
+  if (frameSinks.empty())
+    return nullptr;
+  auto it = frameSinks.find(fb);
+  return it == frameSinks.end() ? nullptr : it->second;
+}
+
+/*! python handle for a frame ring */
+struct FrameRingObject {
+  PyObject_HEAD
+  std::shared_ptr<FrameRing> *ring;
+};
+
+static PyTypeObject FrameRingType = { PyVarObject_HEAD_INIT(NULL, 0) };
+
+/*! detach a ring from all frame buffers, and drop our reference;
+    frames still being published keep it alive until they're done */
+void closeFrameRing(FrameRingObject *self)
+{
+  if (!self->ring) return;
+  for (auto it = frameSinks.begin(); it != frameSinks.end(); )
+    if (it->second == *self->ring) it = frameSinks.erase(it); else ++it;
+  delete self->ring;
+  self->ring = nullptr;
+}
+
+static void FrameRing_dealloc(FrameRingObject *self)
+{
+  closeFrameRing(self);
+  Py_TYPE(self)->tp_free((PyObject*)self);
+}
+
+static PyObject *FrameRing_close(FrameRingObject *self, PyObject *args)
+{
+  closeFrameRing(self);
+  Py_INCREF(Py_None);
+  return Py_None;
+}
+
+static PyObject *FrameRing_enter(FrameRingObject *self, PyObject *args)
+{
+  Py_INCREF(self);
+  return (PyObject*)self;
+}
+
+static PyObject *FrameRing_getName(FrameRingObject *self, void *)
+{
+  if (!self->ring) {
+    Py_INCREF(Py_None);
+    return Py_None;
+  }
+  return PyUnicode_FromString((*self->ring)->name.c_str());
+}
+
+static PyObject *FrameRing_getPublished(FrameRingObject *self, void *)
+{
+  if (!self->ring) {
+    Py_INCREF(Py_None);
+    return Py_None;
+  }
+  return PyLong_FromUnsignedLongLong((*self->ring)->header->published.load());
+}
+
+static PyMethodDef FrameRing_methods[] = {
+  {"close",    (PyCFunction)FrameRing_close, METH_NOARGS,  "detach the ring from its frame buffers and unlink its shared memory."},
+  {"__enter__",(PyCFunction)FrameRing_enter, METH_NOARGS,  "context manager entry; returns self."},
+  {"__exit__", (PyCFunction)FrameRing_close, METH_VARARGS, "context manager exit; closes."},
+  {NULL, NULL, 0, NULL}
+};
+
+static PyGetSetDef FrameRing_getset[] = {
+  {(char*)"name",      (getter)FrameRing_getName,      NULL, (char*)"shared memory object name (None once closed).", NULL},
+  {(char*)"published", (getter)FrameRing_getPublished, NULL, (char*)"number of frames published so far (None once closed).", NULL},
+  {NULL, NULL, NULL, NULL, NULL}
+};
+
+/*! set up the FrameRing type; to be called during module init */
+int initFrameRingType()
+{
+  PyTypeObject &t = FrameRingType;
+  t.tp_name      = "ospray.FrameRing";
+  t.tp_basicsize = sizeof(FrameRingObject);
+  t.tp_dealloc   = (destructor)FrameRing_dealloc;
+  t.tp_flags     = Py_TPFLAGS_DEFAULT;
+  t.tp_doc       = "shared-memory ring buffer that rendered frames get published to.";
+  t.tp_methods   = FrameRing_methods;
+  t.tp_getset    = FrameRing_getset;
+  return PyType_Ready(&t);
+}
+
+
+
+// ##################################################################
+// asynchronous rendering
+// ##################################################################
+
+/*! calls obj.name(args...), with a null-terminated list of up to
+    three arguments; returns a new reference, or NULL on error */
+PyObject *callMethod(PyObject *obj, const char *name,
+                     PyObject *arg0=NULL, PyObject *arg1=NULL, PyObject *arg2=NULL)
+{
+  PyObject *method = PyObject_GetAttrString(obj,name);
+  if (!method) return NULL;
+  PyObject *result = PyObject_CallFunctionObjArgs(method,arg0,arg1,arg2,NULL);
+  Py_DECREF(method);
+  return result;
+}
+
+/*! one frame to be rendered by the render worker thread */
+struct RenderTask {
+  enum State { PENDING, RUNNING, DONE, CANCELLED };
+
+  OSPFrameBuffer fb;
+  OSPRenderer    renderer;
+  uint32_t       channels;
+
+  std::mutex              mutex;
+  std::condition_variable finished;
+  State                   state      { PENDING };
+  float                   variance   { 0.f };
+  double                  renderTime { 0. };
+  /*! frame ring to publish the frame to, if any */
+  std::shared_ptr<FrameRing> sink;
+  /*! asyncio loop and future to resolve when done (if awaited);
+      owned references */
+  PyObject               *loop       { nullptr };
+  PyObject               *future     { nullptr };
+
+  bool isFinished() const { return state == DONE || state == CANCELLED; }
+};
+
+/*! a single native thread that renders the frames queued by
+    ospRenderFrameAsync, in order. ospray already uses all cores for
+    each frame, so there's nothing to gain from more than one */
+struct RenderWorker {
+  std::mutex                              mutex;
+  std::condition_variable                 workAvailable;
+  std::condition_variable                 idle;
+  std::deque<std::shared_ptr<RenderTask>> queue;
+  bool                                    busy    { false };
+  bool                                    started { false };
+
+  void push(const std::shared_ptr<RenderTask> &task);
+  /*! block until all queued frames are done; call w/o the GIL */
+  void waitIdle();
+  bool isIdle();
+  void run();
+};
+
+/*! never destroyed, since the (detached) worker thread may still be
+    waiting on it during process exit */
+static RenderWorker *renderWorker = new RenderWorker;
+
+/*! 'future._resolve(value)' helper that the worker schedules on the
+    asyncio loop; ignores futures that got cancelled meanwhile */
+static PyObject *resolveFuture(PyObject *self, PyObject *args)
+{
+  PyObject *future, *value;
+  if (!PyArg_ParseTuple(args, "OO", &future, &value))
+    return NULL;
+  PyObject *done = callMethod(future,"done");
+  if (!done) return NULL;
+  const int isDone = PyObject_IsTrue(done);
+  Py_DECREF(done);
+  if (isDone) {
+    Py_INCREF(Py_None);
+    return Py_None;
+  }
+  return callMethod(future,"set_result",value);
+}
+
+static PyMethodDef resolveFutureDef
+= {"_resolveFuture", resolveFuture, METH_VARARGS, "resolve an asyncio future unless done."};
+static PyObject *resolveFutureFunc = nullptr;
+
+void RenderWorker::push(const std::shared_ptr<RenderTask> &task)
+{
+  std::lock_guard<std::mutex> lock(mutex);
+  if (!started) {
+    std::thread(&RenderWorker::run,this).detach();
+    started = true;
+  }
+  queue.push_back(task);
+  workAvailable.notify_one();
+}
+
+void RenderWorker::waitIdle()
+{
+  std::unique_lock<std::mutex> lock(mutex);
+  idle.wait(lock,[&]{ return queue.empty() && !busy; });
+}
+
+bool RenderWorker::isIdle()
+{
+  std::lock_guard<std::mutex> lock(mutex);
+  return queue.empty() && !busy;
+}
+
+void RenderWorker::run()
+{
+  while (1) {
+    std::shared_ptr<RenderTask> task;
+    {
+      std::unique_lock<std::mutex> lock(mutex);
+      busy = false;
+      idle.notify_all();
+      workAvailable.wait(lock,[&]{ return !queue.empty(); });
+      task = queue.front();
+      queue.pop_front();
+      busy = true;
+    }
+    {
+      std::lock_guard<std::mutex> lock(task->mutex);
+      if (task->state == RenderTask::CANCELLED)
+        continue;
+      task->state = RenderTask::RUNNING;
+    }
+
+    const auto begin = std::chrono::steady_clock::now();
+    const float variance = ospRenderFrame(task->fb,task->renderer,task->channels);
+    const auto end = std::chrono::steady_clock::now();
+    // don't keep the ring alive (and its memory linked) for as long
+    // as the future lives
+    std::shared_ptr<FrameRing> sink = std::move(task->sink);
+    if (sink)
+      sink->publish(task->fb);
+
+    PyObject *loop, *future;
+    {
+      std::lock_guard<std::mutex> lock(task->mutex);
+      task->variance   = variance;
+      task->renderTime = std::chrono::duration<double>(end-begin).count();
+      task->state      = RenderTask::DONE;
+      loop   = task->loop;
+      future = task->future;
+      task->loop = task->future = nullptr;
+    }
+    task->finished.notify_all();
+
+    if (future) {
+      PyGILState_STATE gil = PyGILState_Ensure();
+      PyObject *value  = PyFloat_FromDouble(variance);
+      PyObject *result = callMethod(loop,"call_soon_threadsafe",
+                                    resolveFutureFunc,future,value);
+      // fails only if the loop got closed - then nobody's waiting anyway
+      if (!result) PyErr_Clear();
+      Py_XDECREF(result);
+      Py_XDECREF(value);
+      Py_DECREF(future);
+      Py_DECREF(loop);
+      PyGILState_Release(gil);
+    }
+  }
+}
+
+/*! python handle for a frame queued by ospRenderFrameAsync */
+struct RenderFuture {
+  PyObject_HEAD
+  std::shared_ptr<RenderTask> *task;
+};
+
+static PyTypeObject RenderFutureType = { PyVarObject_HEAD_INIT(NULL, 0) };
+
+static void RenderFuture_dealloc(RenderFuture *self)
+{
+  delete self->task;
+  Py_TYPE(self)->tp_free((PyObject*)self);
+}
+
+static PyObject *RenderFuture_wait(RenderFuture *self, PyObject *args)
+{
+  double timeout = -1.;
+  if (!PyArg_ParseTuple(args, "|d", &timeout))
+    return NULL;
+  RenderTask *task = self->task->get();
+  bool done;
+  Py_BEGIN_ALLOW_THREADS
+  {
+    std::unique_lock<std::mutex> lock(task->mutex);
+    auto isFinished = [&]{ return task->isFinished(); };
+    if (timeout < 0.) {
+      task->finished.wait(lock,isFinished);
+      done = true;
+    } else
+      done = task->finished.wait_for(lock,std::chrono::duration<double>(timeout),
+                                     isFinished);
+  }
+  Py_END_ALLOW_THREADS
+  return PyBool_FromLong(done);
+}
+
+static PyObject *RenderFuture_isReady(RenderFuture *self, PyObject *args)
+{
+  RenderTask *task = self->task->get();
+  std::lock_guard<std::mutex> lock(task->mutex);
+  return PyBool_FromLong(task->isFinished());
+}
+
+static PyObject *RenderFuture_cancel(RenderFuture *self, PyObject *args)
+{
+  RenderTask *task = self->task->get();
+  PyObject *future = nullptr, *loop = nullptr;
+  {
+    std::lock_guard<std::mutex> lock(task->mutex);
+    if (task->state != RenderTask::PENDING)
+      return PyBool_FromLong(0);
+    task->state = RenderTask::CANCELLED;
+    future = task->future;
+    loop   = task->loop;
+    task->future = task->loop = nullptr;
+  }
+  task->finished.notify_all();
+  if (future) {
+    PyObject *result = callMethod(future,"cancel");
+    Py_XDECREF(result);
+    Py_DECREF(future);
+    Py_DECREF(loop);
+    if (!result) return NULL;
+  }
+  return PyBool_FromLong(1);
+}
+
+/*! 'await future': resolves to the frame variance */
+static PyObject *RenderFuture_await(RenderFuture *self)
+{
+  PyObject *asyncio = PyImport_ImportModule("asyncio");
+  if (!asyncio) return NULL;
+  // awaited from a coroutine, so there is a running loop (and if not,
+  // this raises rather than making a new one)
+  PyObject *loop = callMethod(asyncio,"get_running_loop");
+  Py_DECREF(asyncio);
+  if (!loop) return NULL;
+  PyObject *future = callMethod(loop,"create_future");
+  if (!future) { Py_DECREF(loop); return NULL; }
+  if (!resolveFutureFunc)
+    resolveFutureFunc = PyCFunction_New(&resolveFutureDef,NULL);
+
+  RenderTask *task = self->task->get();
+  RenderTask::State state;
+  float variance;
+  {
+    std::lock_guard<std::mutex> lock(task->mutex);
+    state    = task->state;
+    variance = task->variance;
+    if (!task->isFinished() && !task->future) {
+      // the worker resolves (and releases) these once the frame is done
+      Py_INCREF(future);
+      Py_INCREF(loop);
+      task->future = future;
+      task->loop   = loop;
+    } else if (!task->isFinished()) {
+      // awaited more than once: wait on the first future
+      Py_DECREF(future);
+      future = task->future;
+      Py_INCREF(future);
+    }
+  }
+  Py_DECREF(loop);
+
+  PyObject *result = nullptr;
+  if (state == RenderTask::DONE) {
+    PyObject *value = PyFloat_FromDouble(variance);
+    result = callMethod(future,"set_result",value);
+    Py_DECREF(value);
+  } else if (state == RenderTask::CANCELLED)
+    result = callMethod(future,"cancel");
+  else {
+    result = Py_None;
+    Py_INCREF(result);
+  }
+  if (!result) { Py_DECREF(future); return NULL; }
+  Py_DECREF(result);
+
+  PyObject *iter = callMethod(future,"__await__");
+  Py_DECREF(future);
+  return iter;
+}
+
+/*! getter for the per-frame results, which are None until done */
+static PyObject *RenderFuture_getResult(RenderFuture *self, void *which)
+{
+  RenderTask *task = self->task->get();
+  std::lock_guard<std::mutex> lock(task->mutex);
+  if (task->state != RenderTask::DONE) {
+    Py_INCREF(Py_None);
+    return Py_None;
+  }
+  return PyFloat_FromDouble(which ? task->renderTime : task->variance);
+}
+
+static PyMethodDef RenderFuture_methods[] = {
+  {"wait",     (PyCFunction)RenderFuture_wait,    METH_VARARGS, "wait([timeout]): wait for the frame to finish; returns False on timeout."},
+  {"is_ready", (PyCFunction)RenderFuture_isReady, METH_NOARGS,  "check whether the frame is done (or cancelled)."},
+  {"cancel",   (PyCFunction)RenderFuture_cancel,  METH_NOARGS,  "cancel the frame if it hasn't started rendering yet."},
+  {NULL, NULL, 0, NULL}
+};
+
+static PyGetSetDef RenderFuture_getset[] = {
+  {(char*)"variance",   (getter)RenderFuture_getResult, NULL,
+   (char*)"frame variance reported by ospRenderFrame (None until done).", (void*)0},
+  {(char*)"renderTime", (getter)RenderFuture_getResult, NULL,
+   (char*)"time spent in ospRenderFrame, in seconds (None until done).", (void*)1},
+  {NULL}
+};
+
+static PyAsyncMethods RenderFuture_asAsync;
+
+/*! set up the RenderFuture type; to be called during module init */
+int initRenderFutureType()
+{
+  RenderFuture_asAsync.am_await = (unaryfunc)RenderFuture_await;
+
+  PyTypeObject &t = RenderFutureType;
+  t.tp_name      = "ospray.RenderFuture";
+  t.tp_basicsize = sizeof(RenderFuture);
+  t.tp_dealloc   = (destructor)RenderFuture_dealloc;
+  t.tp_flags     = Py_TPFLAGS_DEFAULT;
+  t.tp_as_async  = &RenderFuture_asAsync;
+  t.tp_doc       = "handle for a frame rendered by ospRenderFrameAsync.";
+  t.tp_methods   = RenderFuture_methods;
+  t.tp_getset    = RenderFuture_getset;
+  return PyType_Ready(&t);
+}
+
+
+
+// ##################################################################
+// multi-view rendering
+// ##################################################################
+
+/*! the one native thread that copies finished views out of their
+    frame buffers for renderViews; started on first use and kept for
+    later calls. Its ospMapFrameBuffer/ospUnmapFrameBuffer overlap
+    ospRenderFrame into the *other* frame buffer. The ospray 1.x API
+    isn't thread safe in general, so this relies on the local device,
+    where mapping a frame buffer only hands out its pixel memory; no
+    other ospray call is ever made from this thread */
+struct ViewCopier {
+  std::mutex              mutex;
+  std::condition_variable changed;
+  /*! the copy in progress (or about to start), if fb is set */
+  OSPFrameBuffer          fb       { nullptr };
+  unsigned char          *dst      { nullptr };
+  size_t                  numBytes { 0 };
+  bool                    started  { false };
+
+  /*! wait for the previous copy, then start copying fb's colors to
+      dst; call w/o the GIL */
+  void copy(OSPFrameBuffer fb, unsigned char *dst, size_t numBytes);
+  /*! block until the last copy is done; call w/o the GIL */
+  void wait();
+  void run();
+};
+
+/*! never destroyed, for the same reason as renderWorker */
+static ViewCopier *viewCopier = new ViewCopier;
+
+void ViewCopier::copy(OSPFrameBuffer newFb, unsigned char *newDst, size_t newNumBytes)
+{
+  std::unique_lock<std::mutex> lock(mutex);
+  if (!started) {
+    std::thread(&ViewCopier::run,this).detach();
+    started = true;
+  }
+  changed.wait(lock,[&]{ return fb == nullptr; });
+  fb       = newFb;
+  dst      = newDst;
+  numBytes = newNumBytes;
+  changed.notify_all();
+}
+
+void ViewCopier::wait()
+{
+  std::unique_lock<std::mutex> lock(mutex);
+  changed.wait(lock,[&]{ return fb == nullptr; });
+}
+
+void ViewCopier::run()
+{
+  std::unique_lock<std::mutex> lock(mutex);
+  while (1) {
+    changed.wait(lock,[&]{ return fb != nullptr; });
+    lock.unlock();
+    const void *pixels = ospMapFrameBuffer(fb,OSP_FB_COLOR);
+    memcpy(dst,pixels,numBytes);
+    ospUnmapFrameBuffer(pixels,fb);
+    lock.lock();
+    fb = nullptr;
+    changed.notify_all();
+  }
+}
+
+/*! renders one frame per view (nine floats each: camera pos, dir and
+    up) into 'out', as consecutive color images of the size of the
+    given two (color only) frame buffers. Uses those in turns: while
+    ospray renders view i into one, the viewCopier copies view i-1
+    out of the other, and the camera gets updated and committed for
+    the next view. Touches no python objects, so call without the
+    GIL */
+void renderViews(OSPRenderer renderer, OSPCamera camera,
+                 const std::vector<float> &views, OSPFrameBuffer fbs[2],
+                 size_t viewBytes, unsigned char *out)
+{
+  const size_t numViews = views.size()/9;
+
+  for (size_t i = 0; i < numViews; i++) {
+    const float *view = &views[9*i];
+    ospSet3fv(camera,"pos",view);
+    ospSet3fv(camera,"dir",view+3);
+    ospSet3fv(camera,"up", view+6);
+    ospCommit(camera);
+    ospFrameBufferClear(fbs[i%2],OSP_FB_COLOR);
+    ospRenderFrame(fbs[i%2],renderer,OSP_FB_COLOR);
+    // view i-1 has to be out of the frame buffer that view i+1 goes
+    // to; copy() waits for that before handing over view i
+    viewCopier->copy(fbs[i%2],out+i*viewBytes,viewBytes);
+  }
+  viewCopier->wait();
+}
+
+
+
+// ##################################################################
+// object dependencies and in-place data updates
+// ##################################################################
+
+/*! drops what these bindings keep about an object that ospray no
+    longer uses: its handle got released, and nothing still alive uses
+    it (see Dependencies::release) */
+void forgetObject(OSPObject object);
+
+/*! which objects use which others: data arrays and objects set as
+    parameters (ospSetData, ospSetObject), geometries and volumes
+    added to models, models instanced into geometries or other
+    models. ospray 1.x doesn't expose this, but after a data array
+    changed in place everything that uses it - directly or not - needs
+    a commit to pick up the change; and ospray keeps objects alive
+    for as long as anything uses them, after their handles got
+    released. An object stays in here until then, too: while its
+    handle is live (in liveObjects), or anything in here uses it.
+    Objects using each other in a cycle never leave */
+struct Dependencies {
+  /*! 'user' holds on to 'used' (model members, instanced models) */
+  void add(OSPObject used, OSPObject user)
+  {
+    if (!used || !user) return;
+    users[used].insert(user);
+    uses[user].insert(used);
+    commitOrders.clear();
+  }
+
+  /*! parameter 'name' of 'user' is 'used' now, rather than whatever
+      it was before */
+  void set(OSPObject user, const std::string &name, OSPObject used)
+  {
+    if (!user) return;
+    OSPObject &param = params[user][name];
+    const OSPObject replaced = param;
+    if (replaced == used) return;
+    param = used;
+    add(used,user);
+    if (!replaced) return;
+    eraseOne(users[replaced],user);
+    eraseOne(uses[user],replaced);
+    commitOrders.clear();
+    release(replaced);
+  }
+
+  /*! 'object' may no longer be used: if its handle was released and
+      nothing left in here uses it, forget it - and then, in turn,
+      what it used */
+  void release(OSPObject object)
+  {
+    std::vector<OSPObject> candidates { object };
+    while (!candidates.empty()) {
+      object = candidates.back();
+      candidates.pop_back();
+      auto u = users.find(object);
+      if (liveObjects.count(object) || (u != users.end() && !u->second.empty()))
+        continue;
+      if (u != users.end())
+        users.erase(u);
+      params.erase(object);
+      auto it = uses.find(object);
+      if (it != uses.end()) {
+        for (OSPObject used : it->second) {
+          if (users[used].erase(object))
+            candidates.push_back(used);
+        }
+        uses.erase(it);
+      }
+      commitOrders.clear();
+      forgetObject(object);
+    }
+  }
+
+  void clear() { users.clear(); uses.clear(); params.clear(); commitOrders.clear(); }
+
+  /*! everything that (transitively) uses 'object', each one after the
+      objects it uses - the order to commit them in. Cached until the
+      dependencies change, so per-frame updates don't allocate */
+  const std::vector<OSPObject> &commitOrder(OSPObject object)
+  {
+    auto it = commitOrders.find(object);
+    if (it != commitOrders.end())
+      return it->second;
+    std::vector<OSPObject> &order = commitOrders[object];
+    std::set<OSPObject> visited;
+    visit(object,visited,order);
+    order.pop_back();
+    std::reverse(order.begin(),order.end());
+    return order;
+  }
+
+private:
+  static void eraseOne(std::multiset<OSPObject> &objects, OSPObject object)
+  {
+    auto it = objects.find(object);
+    if (it != objects.end()) objects.erase(it);
+  }
+
+  /*! depth first; appends 'object' after all of its users */
+  void visit(OSPObject object, std::set<OSPObject> &visited, std::vector<OSPObject> &order)
+  {
+    if (!visited.insert(object).second) return;
+    auto it = users.find(object);
+    if (it != users.end())
+      for (OSPObject user : it->second)
+        visit(user,visited,order);
+    order.push_back(object);
+  }
+
+  /*! one entry per use, e.g. a geometry added to a model twice */
+  std::map<OSPObject,std::multiset<OSPObject>>         users;
+  std::map<OSPObject,std::multiset<OSPObject>>         uses;
+  std::map<OSPObject,std::map<std::string,OSPObject>> params;
+  std::map<OSPObject,std::vector<OSPObject>>          commitOrders;
+};
+
+static Dependencies dependencies;
+
+void addElementDependencies(OSPData data, const DataFormat &df, size_t numItems,
+                            const void *items)
+{
+  if (df.scalar != 'P') return;
+  for (size_t i = 0; i < numItems; i++)
+    dependencies.add(((const OSPObject *)items)[i],(OSPObject)data);
+}
+
+/*! the shared memory of a data object that may be updated in place;
+    throws if there is none (data created with flags = 0, or by
+    ospLoadMesh), if it's in the data cache (which may hand the same
+    object to several callers), or if it's a read-only python buffer */
+SharedDataMemory &updatableData(OSPObject data)
+{
+  auto it = sharedDataMemory.find(data);
+  if (it == sharedDataMemory.end() || !it->second->format)
+    throw std::runtime_error("not a data object that shares its memory "
+                             "(flags = OSP_DATA_SHARED_BUFFER)");
+  if (dataCache.contains(data))
+    throw std::runtime_error("data from the data cache cannot be updated");
+  if (it->second->format->scalar == 'P')
+    throw std::runtime_error("object arrays cannot be updated in place");
+  SharedDataMemory &memory = *it->second;
+  if (memory.view && memory.view->readonly)
+    throw std::runtime_error("data shares a read-only buffer");
+  return memory;
+}
+
+/*! a buffer view of 'values' whose items match the data format of
+    'memory'; throws otherwise. Release it with PyBuffer_Release */
+void updateValues(PyObject *values, const SharedDataMemory &memory, Py_buffer &view)
+{
+  if (PyObject_GetBuffer(values,&view,PyBUF_RECORDS_RO) != 0) {
+    PyErr_Clear();
+    throw std::runtime_error("expected a buffer (e.g., a numpy array)");
+  }
+  const DataFormat &df = *memory.format;
+  const size_t itemSize = df.numScalars*scalarSize(df);
+  std::string error;
+  if (!bufferMatchesFormat(view,df))
+    error = std::string("buffer element type '")+(view.format?view.format:"?")
+      +"' does not match data format '"+df.name+"'";
+  else if (view.len % itemSize)
+    error = "buffer has "+std::to_string(view.len)+" bytes, which is no whole number of '"
+      +df.name+"' items";
+  if (!error.empty()) {
+    PyBuffer_Release(&view);
+    throw std::runtime_error(error);
+  }
+}
+
+/*! copies all of 'view' to 'dst'; strided buffers get gathered
+    right into place. Needs the GIL */
+void copyValues(const Py_buffer &view, unsigned char *dst)
+{
+  if (PyBuffer_IsContiguous(&view,'C')) {
+    memmove(dst,view.buf,view.len);
+    return;
+  }
+  if (PyBuffer_ToContiguous(dst,(Py_buffer *)&view,view.len,'C') < 0) {
+    PyErr_Clear();
+    throw std::runtime_error("cannot gather strided buffer");
+  }
+}
+
+/*! commits what uses a data object after its items changed in place.
+    The order gets copied first, so the commits can run without the
+    GIL while other threads change the dependencies */
+size_t commitDependents(OSPObject data)
+{
+  static thread_local std::vector<OSPObject> toCommit;
+  toCommit.assign(dependencies.commitOrder(data).begin(),dependencies.commitOrder(data).end());
+  Py_BEGIN_ALLOW_THREADS
+  for (OSPObject object : toCommit)
+    ospCommit(object);
+  Py_END_ALLOW_THREADS
+  return toCommit.size();
+}
+
+
+
+// ##################################################################
+// object release
+// ##################################################################
+
+void forgetObject(OSPObject object)
+{
+  releaseSharedDataBuffer(object);
+  sceneFiles.erase(object);
+  frameBufferInfos.erase(object);
+  frameSinks.erase(object);
+}
+
+/*! release an object's handle, along with everything these bindings
+    keep about it - or, for what ospray may still use through other
+    objects, keep until that's gone, too */
+void releaseObject(OSPObject object)
+{
+  // the data cache owns the reference of cached data (until evicted),
+  // which may be shared by several ospNewData calls
+  if (dataCache.contains(object))
+    return;
+  ospRelease(object);
+  releaseSceneObject(object);
+  auto it = liveObjects.find(object);
+  if (it != liveObjects.end()) {
+    if (it->second)
+      it->second->handle = nullptr;
+    liveObjects.erase(it);
+  }
+  dependencies.release(object);
+}
+
+/*! release all objects whose wrappers died since the last call. This
+    gets called from scene setup functions (object creation, ospCommit,
+    ospRelease) rather than from the wrappers' dealloc, so garbage
+    collection never releases anything in the middle of a frame; for
+    the same reason it does nothing while async frames are in flight */
+void drainReleases()
+{
+  if (pendingReleases.empty() || !renderWorker->isIdle())
+    return;
+  std::vector<OSPObject> handles;
+  handles.swap(pendingReleases);
+  for (auto handle : handles) {
+    // skip handles that got released explicitly (ospRelease of the
+    // raw int) meanwhile - and with them, any new object ospray may
+    // have created at the same address
+    auto it = liveObjects.find(handle);
+    if (it != liveObjects.end() && !it->second)
+      releaseObject(handle);
+  }
+}
+
+static void Object_dealloc(ObjectWrapper *self)
+{
+  if (self->handle) {
+    liveObjects[self->handle] = nullptr;
+    pendingReleases.push_back(self->handle);
+  }
+  Py_TYPE(self)->tp_free((PyObject*)self);
+}
+
+static PyObject *Object_repr(ObjectWrapper *self)
+{
+  if (!self->handle)
+    return PyUnicode_FromFormat("<%s (released)>",Py_TYPE(self)->tp_name);
+  return PyUnicode_FromFormat("<%s %p>",Py_TYPE(self)->tp_name,(void*)self->handle);
+}
+
+static PyObject *Object_release(ObjectWrapper *self, PyObject *args)
+{
+  if (self->handle)
+    releaseObject(self->handle);
+  Py_INCREF(Py_None);
+  return Py_None;
+}
+
+static PyObject *Object_enter(ObjectWrapper *self, PyObject *args)
+{
+  Py_INCREF(self);
+  return (PyObject*)self;
+}
+
+static PyObject *Object_getHandle(ObjectWrapper *self, void *)
+{
+  if (!self->handle) {
+    Py_INCREF(Py_None);
+    return Py_None;
+  }
+  return PyLong_FromVoidPtr((void*)self->handle);
+}
+
+static PyMethodDef Object_methods[] = {
+  {"release",  (PyCFunction)Object_release, METH_NOARGS,  "release the object right away."},
+  {"__enter__",(PyCFunction)Object_enter,   METH_NOARGS,  "context manager entry; returns self."},
+  {"__exit__", (PyCFunction)Object_release, METH_VARARGS, "context manager exit; releases the object."},
+  {NULL, NULL, 0, NULL}
+};
+
+static PyGetSetDef Object_getset[] = {
+  {(char*)"handle", (getter)Object_getHandle, NULL,
+   (char*)"the raw ospray handle, as int (None once released).", NULL},
+  {NULL}
+};
+
+/*! the python types of all object wrappers, with their docs */
+static const struct {
+  PyTypeObject *type;
+  const char   *name;
+  const char   *doc;
+} objectTypes[] = {
+  { &ObjectType,      "ospray.Object",      "ospray object handle; released once unreferenced." },
+  { &CameraType,      "ospray.Camera",      "ospray camera." },
+  { &RendererType,    "ospray.Renderer",    "ospray renderer." },
+  { &LightType,       "ospray.Light",       "ospray light." },
+  { &ModelType,       "ospray.Model",       "ospray model." },
+  { &GeometryType,    "ospray.Geometry",    "ospray geometry." },
+  { &DataType,        "ospray.Data",        "ospray data array." },
+  { &FrameBufferType, "ospray.FrameBuffer", "ospray frame buffer." },
+  { &VolumeType,      "ospray.Volume",      "ospray volume." },
+  { &TransferFunctionType, "ospray.TransferFunction", "ospray transfer function." },
+};
+
+/*! set up the object wrapper types and add them to the module; to be
+    called during module init */
+int initObjectTypes(PyObject *module)
+{
+  for (auto &ot : objectTypes) {
+    PyTypeObject &t = *ot.type;
+    if (!t.tp_name) {
+      t.tp_name      = ot.name;
+      t.tp_basicsize = sizeof(ObjectWrapper);
+      t.tp_doc       = ot.doc;
+      if (&t == &ObjectType) {
+        t.tp_flags   = Py_TPFLAGS_DEFAULT | Py_TPFLAGS_BASETYPE;
+        t.tp_dealloc = (destructor)Object_dealloc;
+        t.tp_repr    = (reprfunc)Object_repr;
+        t.tp_methods = Object_methods;
+        t.tp_getset  = Object_getset;
+      } else {
+        t.tp_flags   = Py_TPFLAGS_DEFAULT;
+        t.tp_base    = &ObjectType;
+      }
+      if (PyType_Ready(&t) < 0)
+        return -1;
+    }
+    Py_INCREF(&t);
+    if (PyModule_AddObject(module,strchr(ot.name,'.')+1,(PyObject*)&t) < 0) {
+      Py_DECREF(&t);
+      return -1;
+    }
+  }
+  return 0;
+}
+
+
+
+// ##################################################################
+// background image saving
+// ##################################################################
+
+/*! a frame buffer copy waiting to be encoded and written */
+struct SaveJob {
+  std::string                fileName;
+  ImageFileType              fileType;
+  osp::vec2i                 size;
+  PixelType                  pixelType;
+  int                        compressionLevel;
+  std::vector<unsigned char> pixels;
+};
+
+/*! a bounded pool of native threads that encode and write the frames
+    queued by ospFrameBufferSaveAsync. 'maxInFlight' caps how many
+    frame copies (queued or being written) may exist at any time;
+    queueing more blocks until one is done */
+struct SaveQueue {
+  std::mutex                           mutex;
+  std::condition_variable              workAvailable;
+  std::condition_variable              jobDone;
+  std::deque<std::unique_ptr<SaveJob>> queue;
+  int                                  numInFlight  { 0 };
+  int                                  numThreads   { 0 };
+  int                                  maxThreads   { 2 };
+  int                                  maxInFlight  { 4 };
+  /*! why the saves that failed since the last flush() failed */
+  std::vector<std::string>             errors;
+
+  /*! wait for a free slot, then queue; call w/o the GIL */
+  void push(std::unique_ptr<SaveJob> job);
+  /*! block until all queued frames are written, then return (and
+      forget) the errors collected meanwhile; call w/o the GIL */
+  std::vector<std::string> flush();
+  void run();
+};
+
+/*! never destroyed, for the same reason as the render worker */
+static SaveQueue *saveQueue = new SaveQueue;
+
+void SaveQueue::push(std::unique_ptr<SaveJob> job)
+{
+  std::unique_lock<std::mutex> lock(mutex);
+  jobDone.wait(lock,[&]{ return numInFlight < maxInFlight; });
+  numInFlight++;
+  queue.push_back(std::move(job));
+  if (numThreads < maxThreads && numThreads < numInFlight) {
+    std::thread(&SaveQueue::run,this).detach();
+    numThreads++;
+  }
+  workAvailable.notify_one();
+}
+
+std::vector<std::string> SaveQueue::flush()
+{
+  std::unique_lock<std::mutex> lock(mutex);
+  jobDone.wait(lock,[&]{ return numInFlight == 0; });
+  std::vector<std::string> result;
+  result.swap(errors);
+  return result;
+}
+
+void SaveQueue::run()
+{
+  std::unique_lock<std::mutex> lock(mutex);
+  while (1) {
+    workAvailable.wait(lock,[&]{ return !queue.empty() || numThreads > maxThreads; });
+    if (numThreads > maxThreads) {
+      // pool got shrunk
+      numThreads--;
+      return;
+    }
+    std::unique_ptr<SaveJob> job = std::move(queue.front());
+    queue.pop_front();
+    lock.unlock();
+    std::string error;
+    try {
+      writeImage(job->fileName,job->fileType,job->size,job->pixelType,
+                 job->pixels.data(),job->compressionLevel);
+    } catch (const std::exception &e) {
+      error = e.what();
+    }
+    job.reset();
+    lock.lock();
+    if (!error.empty())
+      errors.push_back(error);
+    numInFlight--;
+    jobDone.notify_all();
+  }
+}
+
+/*! sets an IOError listing the failed background saves, if any;
+    returns whether there were any */
+bool raiseSaveErrors(const char *function, const std::vector<std::string> &errors)
+{
+  if (errors.empty())
+    return false;
+  std::string message = std::string(function)+": "+std::to_string(errors.size())
+    +(errors.size() == 1 ? " background save failed: " : " background saves failed: ");
+  for (size_t i = 0; i < errors.size(); i++)
+    message += (i ? "; " : "")+errors[i];
+  PyErr_SetString(PyExc_IOError,message.c_str());
+  return true;
+}
+
+
+
+/*! parses and checks the (fileName, fb, size, format [,
+    compressionLevel [, channel]]) arguments of ospFrameBufferSave and
+    ospFrameBufferSaveAsync into everything but the pixels of 'job';
+    returns false (with a python exception set) on error */
+bool parseSaveArgs(const char *function, PyObject *args, PyObject *kwargs,
+                   SaveJob &job, OSPFrameBuffer &fb, OSPFrameBufferChannel &channel)
+{
+  static char *kwlist[] = {
+    (char*)"fileName", (char*)"fb", (char*)"size", (char*)"format",
+    (char*)"compressionLevel", (char*)"channel", NULL
+  };
+  char *fileName;
+  char *format;
+  const char *channelName = "color";
+  job.compressionLevel = Z_DEFAULT_COMPRESSION;
+  if (!PyArg_ParseTupleAndKeywords(args, kwargs, "sO&(ii)s|is", kwlist,
+                                   &fileName, parseHandle, &fb, &job.size.x, &job.size.y,
+                                   &format, &job.compressionLevel, &channelName))
+    return false;
+
+  try {
+    if (job.compressionLevel < -1 || job.compressionLevel > 9)
+      throw std::runtime_error("compression level must be in -1..9");
+    job.fileName = fileName;
+    job.fileType = imageFileType(fileName);
+
+    const OSPFrameBufferFormat fbFormat = parseFrameBufferFormat(format);
+    auto it = frameBufferInfos.find((OSPObject)fb);
+    if (it != frameBufferInfos.end()) {
+      // don't let a wrong size or format read past the mapped pixels
+      const FrameBufferInfo &info = it->second;
+      if (info.size.x != job.size.x || info.size.y != job.size.y)
+        throw std::runtime_error("size does not match the frame buffer's size");
+      if (info.format != fbFormat)
+        throw std::runtime_error("format '"+std::string(format)
+                                 +"' does not match the frame buffer's format");
+    }
+
+    const std::string channelString = channelName;
+    if (channelString == "depth") {
+      if (it != frameBufferInfos.end() && !(it->second.channels & OSP_FB_DEPTH))
+        throw std::runtime_error("frame buffer has no depth channel");
+      channel       = OSP_FB_DEPTH;
+      job.pixelType = PIXEL_DEPTH32F;
+    } else if (channelString == "color") {
+      channel = OSP_FB_COLOR;
+      switch (fbFormat) {
+      case OSP_FB_SRGBA:   job.pixelType = PIXEL_SRGBA8;  break;
+      case OSP_FB_RGBA8:   job.pixelType = PIXEL_RGBA8;   break;
+      case OSP_FB_RGBA32F: job.pixelType = PIXEL_RGBA32F; break;
+      default: throw std::runtime_error("frame buffer has no color channel");
+      }
+    } else
+      throw std::runtime_error("cannot save channel '"+channelString+"'");
+    checkImageFileType(job.fileType,job.pixelType);
+  } catch (const std::runtime_error &e) {
+    PyErr_SetString(PyExc_ValueError,(std::string(function)+": "+e.what()).c_str());
+    return false;
+  }
+  return true;
+}
+
+
+
+// ##################################################################
+// memory-mapped file loading
+// ##################################################################
+
+/*! read-only view of a whole file: memory mapped, or (on windows)
+    simply read into memory; throws on error */
+struct MappedFile
+{
+  MappedFile(const std::string &fileName)
+  {
+#ifdef _WIN32
+    FILE *file = fopen(fileName.c_str(),"rb");
+    if (!file)
+      throw std::runtime_error("cannot open '"+fileName+"'");
+    _fseeki64(file,0,SEEK_END);
+    contents.resize(_ftelli64(file));
+    _fseeki64(file,0,SEEK_SET);
+    const size_t numRead = fread(contents.data(),1,contents.size(),file);
+    fclose(file);
+    if (numRead != contents.size())
+      throw std::runtime_error("cannot read '"+fileName+"'");
+    data = contents.data();
+    size = contents.size();
+#else
+    const int fd = open(fileName.c_str(),O_RDONLY);
+    if (fd < 0)
+      throw std::runtime_error("cannot open '"+fileName+"': "+strerror(errno));
+    struct stat st;
+    if (fstat(fd,&st) != 0) {
+      close(fd);
+      throw std::runtime_error("cannot stat '"+fileName+"': "+strerror(errno));
+    }
+    size = st.st_size;
+    if (size) {
+      void *mapped = mmap(NULL,size,PROT_READ,MAP_PRIVATE,fd,0);
+      if (mapped == MAP_FAILED) {
+        close(fd);
+        throw std::runtime_error("cannot map '"+fileName+"': "+strerror(errno));
+      }
+      data = (const unsigned char *)mapped;
+    }
+    close(fd);
+#endif
+  }
+
+  ~MappedFile()
+  {
+#ifndef _WIN32
+    if (data) munmap((void*)data,size);
+#endif
+  }
+
+  MappedFile(const MappedFile &) = delete;
+  MappedFile &operator=(const MappedFile &) = delete;
+
+#ifdef _WIN32
+  void sequential() const {}
+  void willNeed(size_t begin, size_t end) const {}
+  void dontNeed(size_t begin, size_t end) const {}
+#else
+  /*! the whole file is going to be read front to back */
+  void sequential() const { if (data) madvise((void*)data,size,MADV_SEQUENTIAL); }
+  /*! starts reading ahead (the whole pages within) [begin,end) */
+  void willNeed(size_t begin, size_t end) const { advise(begin,end,MADV_WILLNEED); }
+  /*! drops (the whole pages within) [begin,end) from the mapping */
+  void dontNeed(size_t begin, size_t end) const { advise(begin,end,MADV_DONTNEED); }
+#endif
+
+  const unsigned char *data = nullptr;
+  size_t               size = 0;
+
+private:
+#ifdef _WIN32
+  std::vector<unsigned char> contents;
+#else
+  void advise(size_t begin, size_t end, int advice) const
+  {
+    static const size_t pageSize = sysconf(_SC_PAGESIZE);
+    begin = (begin+pageSize-1) & ~(pageSize-1);
+    end   = std::min(size,end) & ~(pageSize-1);
+    if (begin < end) madvise((void*)(data+begin),end-begin,advice);
+  }
+#endif
+};
+
+/*! size of one voxel of given ospray voxel type, or 0 if unknown */
+size_t voxelSize(const std::string &voxelType)
+{
+  if (voxelType == "uchar")  return 1;
+  if (voxelType == "short")  return 2;
+  if (voxelType == "ushort") return 2;
+  if (voxelType == "float")  return 4;
+  if (voxelType == "double") return 8;
+  return 0;
+}
+
+/*! loads a raw brick file of dims.x*dims.y*dims.z voxels of given
+    type (x fastest, native byte order), starting 'offset' bytes into
+    the file, into the given volume through ospSetRegion, one slab of
+    'slabSlices' z-slices at a time. The file gets memory mapped, so
+    nothing gets staged in an extra copy: while ospray copies one slab
+    the kernel already reads ahead the next, and slabs already copied
+    get dropped from the mapping again. Touches no python objects, so
+    call without the GIL; throws on error */
+void loadRawVolume(OSPVolume volume, const std::string &fileName,
+                   const osp::vec3i &dims, const std::string &voxelType,
+                   size_t offset, int slabSlices,
+                   std::shared_ptr<MappedFile> *keepMapped = nullptr)
+{
+  const size_t vs = voxelSize(voxelType);
+  if (!vs)
+    throw std::runtime_error("unknown voxel type '"+voxelType+"'");
+  if (dims.x <= 0 || dims.y <= 0 || dims.z <= 0)
+    throw std::runtime_error("invalid volume dimensions");
+  const size_t sliceBytes = size_t(dims.x)*dims.y*vs;
+  const size_t totalBytes = sliceBytes*dims.z;
+  if (slabSlices <= 0)
+    slabSlices = (int)std::max<size_t>(1,(64<<20)/sliceBytes);
+
+  auto mapped = std::make_shared<MappedFile>(fileName);
+  const MappedFile &file = *mapped;
+  if (file.size < offset+totalBytes)
+    throw std::runtime_error("'"+fileName+"' is too small for the given dimensions");
+  file.sequential();
+
+  ospSetString(volume,"voxelType",voxelType.c_str());
+  ospSet3i(volume,"dimensions",dims.x,dims.y,dims.z);
+
+  for (int z = 0; z < dims.z; z += slabSlices) {
+    const int numSlices = std::min(slabSlices,dims.z-z);
+    const size_t begin = offset+z*sliceBytes, end = begin+numSlices*sliceBytes;
+    file.willNeed(end,end+numSlices*sliceBytes);
+    const osp::vec3i coords = { 0, 0, z };
+    const osp::vec3i size   = { dims.x, dims.y, numSlices };
+    if (!ospSetRegion(volume,(void*)(file.data+begin),coords,size))
+      throw std::runtime_error("ospSetRegion failed for slices "+std::to_string(z)
+                               +".."+std::to_string(z+numSlices-1));
+    countBytes(end-begin);
+    file.dontNeed(begin,end);
+  }
+  if (keepMapped)
+    *keepMapped = mapped;
+}
+
+
+
+// ##################################################################
+// mesh file loading
+// ##################################################################
+
+/*! triangle mesh as read from an OBJ or PLY file; the attribute
+    arrays are either empty or have one entry per vertex */
+struct Mesh
+{
+  std::vector<float> positions;  //!< 3 floats per vertex
+  std::vector<float> normals;    //!< 3 floats per vertex
+  std::vector<float> colors;     //!< 4 floats per vertex
+  std::vector<float> texcoords;  //!< 2 floats per vertex
+  std::vector<int>   indices;    //!< 3 per triangle
+};
+
+/*! runs task(i) for all i in [0,numTasks) in parallel; the first
+    exception thrown by any of them gets rethrown once all are done */
+template<typename Task>
+void parallelForEach(size_t numTasks, const Task &task)
+{
+  std::mutex mutex;
+  std::exception_ptr error;
+  parallelForRows((int)numTasks,1,[&](int begin, int end) {
+      for (int i = begin; i < end; i++)
+        try {
+          task(i);
+        } catch (...) {
+          std::lock_guard<std::mutex> lock(mutex);
+          if (!error) error = std::current_exception();
+        }
+    });
+  if (error) std::rethrow_exception(error);
+}
+
+/*! splits [begin,end) into chunks of whole lines, about enough to keep
+    all hardware threads busy; chunk i is [chunks[i],chunks[i+1]) */
+std::vector<const char *> splitLines(const char *begin, const char *end)
+{
+  const size_t minChunkSize = 1<<20;
+  const size_t maxChunks    = 8*std::max(1u,std::thread::hardware_concurrency());
+  const size_t numChunks
+    = std::max<size_t>(1,std::min<size_t>(maxChunks,(end-begin)/minChunkSize));
+  std::vector<const char *> chunks = { begin };
+  for (size_t i = 1; i < numChunks; i++) {
+    const char *p   = std::max(chunks.back(),begin+(end-begin)*i/numChunks);
+    const char *eol = (const char *)memchr(p,'\n',end-p);
+    if (!eol) break;
+    chunks.push_back(eol+1);
+  }
+  chunks.push_back(end);
+  return chunks;
+}
+
+inline bool isDigit(char c) { return unsigned(c-'0') < 10; }
+
+/*! 10^e, exact for |e| <= 22 */
+inline double powerOf10(int e)
+{
+  static const double exact[] = {
+    1e0,1e1,1e2,1e3,1e4,1e5,1e6,1e7,1e8,1e9,1e10,1e11,
+    1e12,1e13,1e14,1e15,1e16,1e17,1e18,1e19,1e20,1e21,1e22
+  };
+  return (e >= 0 && e <= 22) ? exact[e] : std::pow(10.0,e);
+}
+
+/*! tokenizer for a range of lines of a text file. Numbers get parsed
+    by hand: strtod() is slow, depends on the locale, and needs a
+    terminating zero that a mapped file doesn't have */
+struct TextScanner
+{
+  const char *p, *end;
+
+  void skipSpaces() { while (p < end && (*p == ' ' || *p == '\t' || *p == '\r')) p++; }
+  /*! whether there's nothing but spaces or a comment left on this line */
+  bool atEndOfLine() { skipSpaces(); return p >= end || *p == '\n' || *p == '#'; }
+  void nextLine()
+  {
+    const char *eol = (const char *)memchr(p,'\n',end-p);
+    p = eol ? eol+1 : end;
+  }
+  /*! the next whitespace separated word on this line */
+  std::string word()
+  {
+    skipSpaces();
+    const char *begin = p;
+    while (p < end && *p != ' ' && *p != '\t' && *p != '\r' && *p != '\n') p++;
+    return std::string(begin,p);
+  }
+
+  bool parseInt(int &value)
+  {
+    skipSpaces();
+    const char *q = p;
+    const bool negative = q < end && *q == '-';
+    if (q < end && (*q == '-' || *q == '+')) q++;
+    if (q >= end || !isDigit(*q)) return false;
+    long long v = 0;
+    while (q < end && isDigit(*q))
+      v = std::min<long long>(v*10+(*q++-'0'),1LL<<40);
+    value = (int)std::max<long long>(INT_MIN,std::min<long long>(INT_MAX,negative ? -v : v));
+    p = q;
+    return true;
+  }
+
+  bool parseFloat(float &value)
+  {
+    skipSpaces();
+    const char *q = p;
+    const bool negative = q < end && *q == '-';
+    if (q < end && (*q == '-' || *q == '+')) q++;
+    double mantissa = 0.;
+    int    exponent = 0;
+    bool   anyDigits = false;
+    for (; q < end && isDigit(*q); anyDigits = true)
+      mantissa = mantissa*10.+(*q++-'0');
+    if (q < end && *q == '.')
+      for (q++; q < end && isDigit(*q); anyDigits = true, exponent--)
+        mantissa = mantissa*10.+(*q++-'0');
+    if (!anyDigits) return false;
+    if (q < end && (*q == 'e' || *q == 'E')) {
+      q++;
+      const bool negativeExp = q < end && *q == '-';
+      if (q < end && (*q == '-' || *q == '+')) q++;
+      if (q >= end || !isDigit(*q)) return false;
+      int e = 0;
+      while (q < end && isDigit(*q))
+        e = std::min(e*10+(*q++-'0'),1000);
+      exponent += negativeExp ? -e : e;
+    }
+    const double v = exponent < 0 ? mantissa/powerOf10(-exponent) : mantissa*powerOf10(exponent);
+    value = float(negative ? -v : v);
+    p = q;
+    return true;
+  }
+};
+
+/*! throws unless all indices are valid vertex indices */
+void checkIndices(const Mesh &mesh, const std::string &fileName)
+{
+  const size_t numVertices = mesh.positions.size()/3;
+  const size_t blockSize   = 1<<20;
+  parallelForEach((mesh.indices.size()+blockSize-1)/blockSize,[&](size_t block) {
+      const size_t end = std::min(mesh.indices.size(),(block+1)*blockSize);
+      for (size_t i = block*blockSize; i < end; i++)
+        if (mesh.indices[i] < 0 || size_t(mesh.indices[i]) >= numVertices)
+          throw std::runtime_error("'"+fileName+"' has a vertex index out of range");
+    });
+}
+
+/*! one corner of an OBJ face: position, texcoord and normal index
+    (zero based; -1 if not given) */
+struct OBJCorner
+{
+  int v, vt, vn;
+  bool operator==(const OBJCorner &other) const
+  { return v == other.v && vt == other.vt && vn == other.vn; }
+};
+
+struct OBJCornerHash
+{
+  size_t operator()(const OBJCorner &c) const
+  { return (size_t(c.v)*0x9E3779B97F4A7C15ull) ^ (size_t(c.vt)*0xBF58476D1CE4E5B9ull) ^ c.vn; }
+};
+
+/*! parses an OBJ file: 'v' (with an optional 'r g b' after the
+    position), 'vn', 'vt' and 'f' statements; polygons get fan
+    triangulated, everything else (groups, materials, ...) gets
+    ignored. Runs two parallel passes over chunks of lines: the first
+    only counts vertex statements, so the second already knows where
+    each chunk's vertices go, and what its relative indices refer to */
+void loadOBJ(Mesh &mesh, const MappedFile &file, const std::string &fileName)
+{
+  const char *begin = (const char *)file.data;
+  const std::vector<const char *> chunks = splitLines(begin,begin+file.size);
+  const size_t numChunks = chunks.size()-1;
+
+  enum Statement { VERTEX, NORMAL, TEXCOORD, FACE, OTHER };
+  auto statement = [](TextScanner &line) -> Statement {
+    line.skipSpaces();
+    const char *p = line.p;
+    auto keyword = [&](const char *k, size_t n, Statement s) -> Statement {
+      if (size_t(line.end-p) > n && !memcmp(p,k,n) && (p[n] == ' ' || p[n] == '\t')) {
+        line.p += n;
+        return s;
+      }
+      return OTHER;
+    };
+    if (p >= line.end) return OTHER;
+    if (*p == 'v') {
+      Statement s = keyword("v",1,VERTEX);
+      if (s == OTHER) s = keyword("vn",2,NORMAL);
+      if (s == OTHER) s = keyword("vt",2,TEXCOORD);
+      return s;
+    }
+    return *p == 'f' ? keyword("f",1,FACE) : OTHER;
+  };
+
+  // pass 1: count vertices, normals and texcoords per chunk
+  struct Counts { size_t v = 0, vn = 0, vt = 0; };
+  std::vector<Counts> base(numChunks+1);
+  parallelForEach(numChunks,[&](size_t chunk) {
+      Counts &counts = base[chunk+1];
+      for (TextScanner line = { chunks[chunk], chunks[chunk+1] }; line.p < line.end; line.nextLine())
+        switch (statement(line)) {
+        case VERTEX:   counts.v++;  break;
+        case NORMAL:   counts.vn++; break;
+        case TEXCOORD: counts.vt++; break;
+        default: break;
+        }
+    });
+  for (size_t i = 0; i < numChunks; i++) {
+    base[i+1].v  += base[i].v;
+    base[i+1].vn += base[i].vn;
+    base[i+1].vt += base[i].vt;
+  }
+  const Counts total = base[numChunks];
+
+  // pass 2: parse vertices straight into place, and faces per chunk
+  std::vector<float> positions(3*total.v), normals(3*total.vn), texcoords(2*total.vt);
+  std::vector<float> colors;
+  std::mutex colorsMutex;
+  std::vector<std::vector<OBJCorner>> corners(numChunks);
+  parallelForEach(numChunks,[&](size_t chunk) {
+      Counts next = base[chunk];
+      float *chunkColors = nullptr;
+      std::vector<OBJCorner> polygon;
+      auto error = [&](const char *what) {
+        throw std::runtime_error("'"+fileName+"': "+what);
+      };
+      /*! zero based index for OBJ index i, given the number of
+          items so far and in total */
+      auto index = [&](int i, size_t count, size_t total) -> int {
+        if (i == 0 || (i < 0 && size_t(-(long long)i) > count) || (i > 0 && size_t(i) > total))
+          error("index out of range");
+        return i > 0 ? i-1 : int(count+i);
+      };
+      for (TextScanner line = { chunks[chunk], chunks[chunk+1] }; line.p < line.end; line.nextLine())
+        switch (statement(line)) {
+        case VERTEX: {
+          float *v = &positions[3*next.v];
+          if (!line.parseFloat(v[0]) || !line.parseFloat(v[1]) || !line.parseFloat(v[2]))
+            error("invalid vertex");
+          float rgb[3];
+          if (line.parseFloat(rgb[0]) && line.parseFloat(rgb[1]) && line.parseFloat(rgb[2])) {
+            if (!chunkColors) {
+              std::lock_guard<std::mutex> lock(colorsMutex);
+              if (colors.empty()) colors.resize(4*total.v,1.f);
+              chunkColors = colors.data();
+            }
+            std::copy(rgb,rgb+3,chunkColors+4*next.v);
+          }
+          next.v++;
+        } break;
+        case NORMAL: {
+          float *n = &normals[3*next.vn++];
+          if (!line.parseFloat(n[0]) || !line.parseFloat(n[1]) || !line.parseFloat(n[2]))
+            error("invalid normal");
+        } break;
+        case TEXCOORD: {
+          float *t = &texcoords[2*next.vt++];
+          if (!line.parseFloat(t[0]))
+            error("invalid texture coordinate");
+          if (!line.parseFloat(t[1])) t[1] = 0.f;
+        } break;
+        case FACE: {
+          polygon.clear();
+          while (!line.atEndOfLine()) {
+            OBJCorner c = { -1, -1, -1 };
+            int i;
+            if (!line.parseInt(i)) error("invalid face");
+            c.v = index(i,next.v,total.v);
+            if (line.p < line.end && *line.p == '/') {
+              line.p++;
+              if (line.parseInt(i)) c.vt = index(i,next.vt,total.vt);
+              if (line.p < line.end && *line.p == '/') {
+                line.p++;
+                if (!line.parseInt(i)) error("invalid face");
+                c.vn = index(i,next.vn,total.vn);
+              }
+            }
+            polygon.push_back(c);
+          }
+          for (size_t i = 2; i < polygon.size(); i++) {
+            corners[chunk].push_back(polygon[0]);
+            corners[chunk].push_back(polygon[i-1]);
+            corners[chunk].push_back(polygon[i]);
+          }
+        } break;
+        default: break;
+        }
+    });
+
+  // ospray wants one index per corner for all attributes: use the
+  // position indices directly if the others match them (or aren't
+  // there), else make one vertex per distinct combination
+  bool useNormals = total.vn > 0, useTexcoords = total.vt > 0;
+  bool sameIndices = true;
+  size_t numCorners = 0;
+  for (auto &cs : corners) {
+    numCorners += cs.size();
+    for (auto &c : cs) {
+      useNormals   &= c.vn >= 0;
+      useTexcoords &= c.vt >= 0;
+    }
+  }
+  if (useNormals && total.vn != total.v) sameIndices = false;
+  if (useTexcoords && total.vt != total.v) sameIndices = false;
+  for (auto &cs : corners)
+    for (auto &c : cs)
+      if ((useNormals && c.vn != c.v) || (useTexcoords && c.vt != c.v))
+        sameIndices = false;
+
+  mesh.indices.reserve(numCorners);
+  if (sameIndices) {
+    for (auto &cs : corners)
+      for (auto &c : cs) mesh.indices.push_back(c.v);
+    mesh.positions = std::move(positions);
+    mesh.colors    = std::move(colors);
+    if (useNormals)   mesh.normals   = std::move(normals);
+    if (useTexcoords) mesh.texcoords = std::move(texcoords);
+    return;
+  }
+  std::unordered_map<OBJCorner,int,OBJCornerHash> vertexOf;
+  vertexOf.reserve(total.v);
+  for (auto &cs : corners) {
+    for (auto c : cs) {
+      if (!useNormals)   c.vn = -1;
+      if (!useTexcoords) c.vt = -1;
+      auto it = vertexOf.find(c);
+      if (it == vertexOf.end()) {
+        it = vertexOf.insert({c,int(vertexOf.size())}).first;
+        mesh.positions.insert(mesh.positions.end(),&positions[3*c.v],&positions[3*c.v+3]);
+        if (!colors.empty())
+          mesh.colors.insert(mesh.colors.end(),&colors[4*c.v],&colors[4*c.v+4]);
+        if (useNormals)
+          mesh.normals.insert(mesh.normals.end(),&normals[3*c.vn],&normals[3*c.vn+3]);
+        if (useTexcoords)
+          mesh.texcoords.insert(mesh.texcoords.end(),&texcoords[2*c.vt],&texcoords[2*c.vt+2]);
+      }
+      mesh.indices.push_back(it->second);
+    }
+    std::vector<OBJCorner>().swap(cs);
+  }
+}
+
+/*! one property of a PLY element; types are given as struct module
+    codes (see DataFormat), countType is 0 unless it's a list */
+struct PLYProperty
+{
+  std::string name;
+  char        type;
+  char        countType;
+};
+
+struct PLYElement
+{
+  std::string              name;
+  size_t                   count;
+  std::vector<PLYProperty> properties;
+
+  /*! index of the first of the given properties that exists, or -1 */
+  int find(std::initializer_list<const char *> names) const
+  {
+    for (auto name : names)
+      for (size_t i = 0; i < properties.size(); i++)
+        if (properties[i].name == name && !properties[i].countType) return (int)i;
+    return -1;
+  }
+  bool hasLists() const
+  {
+    for (auto &p : properties) if (p.countType) return true;
+    return false;
+  }
+};
+
+inline char plyType(const std::string &name)
+{
+  if (name == "char"   || name == "int8")    return 'b';
+  if (name == "uchar"  || name == "uint8")   return 'B';
+  if (name == "short"  || name == "int16")   return 'h';
+  if (name == "ushort" || name == "uint16")  return 'H';
+  if (name == "int"    || name == "int32")   return 'i';
+  if (name == "uint"   || name == "uint32")  return 'I';
+  if (name == "float"  || name == "float32") return 'f';
+  if (name == "double" || name == "float64") return 'd';
+  return 0;
+}
+
+inline size_t plyTypeSize(char type)
+{
+  switch (type) {
+  case 'b': case 'B': return 1;
+  case 'h': case 'H': return 2;
+  case 'd':           return 8;
+  default:            return 4;
+  }
+}
+
+/*! scale that maps the given type's values to [0,1] if it's an
+    integer type (for colors) */
+inline float plyColorScale(char type)
+{
+  switch (type) {
+  case 'b': return 1.f/127;
+  case 'B': return 1.f/255;
+  case 'h': return 1.f/32767;
+  case 'H': return 1.f/65535;
+  case 'i': return 1.f/2147483647;
+  case 'I': return 1.f/4294967295.;
+  default:  return 1.f;
+  }
+}
+
+template<typename T> inline double loadAs(const unsigned char *p)
+{ T v; memcpy(&v,p,sizeof(T)); return double(v); }
+
+/*! reads one binary PLY scalar, optionally byte swapped */
+inline double readPLYScalar(const unsigned char *p, char type, bool swap)
+{
+  unsigned char bytes[8];
+  if (swap) {
+    const size_t size = plyTypeSize(type);
+    for (size_t i = 0; i < size; i++) bytes[i] = p[size-1-i];
+    p = bytes;
+  }
+  switch (type) {
+  case 'b': return loadAs<int8_t>(p);
+  case 'B': return loadAs<uint8_t>(p);
+  case 'h': return loadAs<int16_t>(p);
+  case 'H': return loadAs<uint16_t>(p);
+  case 'i': return loadAs<int32_t>(p);
+  case 'I': return loadAs<uint32_t>(p);
+  case 'f': return loadAs<float>(p);
+  default:  return loadAs<double>(p);
+  }
+}
+
+/*! parses an ascii or binary PLY file: x/y/z, nx/ny/nz, red/green/
+    blue(/alpha) and u/v (or s/t) vertex properties and the
+    vertex_indices of faces (fan triangulated); other elements and
+    properties get skipped. Vertices get decoded in parallel, straight
+    into place; ascii files first get their lines counted in parallel,
+    so each chunk of lines knows which records it holds */
+void loadPLY(Mesh &mesh, const MappedFile &file, const std::string &fileName)
+{
+  auto error = [&](const std::string &what) {
+    throw std::runtime_error("'"+fileName+"': "+what);
+  };
+  const char *fileBegin = (const char *)file.data, *fileEnd = fileBegin+file.size;
+
+  // header
+  enum { ASCII, LITTLE_ENDIAN_BINARY, BIG_ENDIAN_BINARY } format = ASCII;
+  std::vector<PLYElement> elements;
+  TextScanner header = { fileBegin, fileEnd };
+  for (header.nextLine(); ; header.nextLine()) {
+    if (header.p >= fileEnd) error("no end_header");
+    const std::string keyword = header.word();
+    if (keyword == "end_header") break;
+    if (keyword == "format") {
+      const std::string f = header.word();
+      if      (f == "ascii")                format = ASCII;
+      else if (f == "binary_little_endian") format = LITTLE_ENDIAN_BINARY;
+      else if (f == "binary_big_endian")    format = BIG_ENDIAN_BINARY;
+      else error("unknown format '"+f+"'");
+    } else if (keyword == "element") {
+      PLYElement element;
+      element.name = header.word();
+      int count;
+      if (!header.parseInt(count) || count < 0) error("invalid element count");
+      element.count = count;
+      elements.push_back(element);
+    } else if (keyword == "property") {
+      if (elements.empty()) error("property without element");
+      PLYProperty property;
+      std::string type = header.word();
+      property.countType = 0;
+      if (type == "list") {
+        property.countType = plyType(header.word());
+        type = header.word();
+        if (!property.countType) error("invalid list count type");
+      }
+      property.type = plyType(type);
+      if (!property.type) error("unknown property type '"+type+"'");
+      property.name = header.word();
+      elements.back().properties.push_back(property);
+    }
+  }
+  header.nextLine();
+  const char *body = header.p;
+
+  // which vertex properties go where
+  const PLYElement *vertices = nullptr, *faces = nullptr;
+  for (auto &e : elements) {
+    if (e.name == "vertex" && !vertices) vertices = &e;
+    if (e.name == "face"   && !faces)    faces    = &e;
+  }
+  if (!vertices) error("no vertex element");
+  if (vertices->hasLists()) error("list properties in vertices are not supported");
+  const int position[3] = { vertices->find({"x"}), vertices->find({"y"}), vertices->find({"z"}) };
+  const int normal[3]   = { vertices->find({"nx"}), vertices->find({"ny"}), vertices->find({"nz"}) };
+  const int color[4]    = { vertices->find({"red","r","diffuse_red"}),
+                            vertices->find({"green","g","diffuse_green"}),
+                            vertices->find({"blue","b","diffuse_blue"}),
+                            vertices->find({"alpha","a"}) };
+  const int texcoord[2] = { vertices->find({"u","s","texture_u","texture_s"}),
+                            vertices->find({"v","t","texture_v","texture_t"}) };
+  if (position[0] < 0 || position[1] < 0 || position[2] < 0)
+    error("vertices without x, y and z");
+  const bool hasNormals   = normal[0] >= 0 && normal[1] >= 0 && normal[2] >= 0;
+  const bool hasColors    = color[0] >= 0 && color[1] >= 0 && color[2] >= 0;
+  const bool hasTexcoords = texcoord[0] >= 0 && texcoord[1] >= 0;
+  const size_t numVertices = vertices->count;
+  mesh.positions.resize(3*numVertices);
+  if (hasNormals)   mesh.normals.resize(3*numVertices);
+  if (hasColors)    mesh.colors.resize(4*numVertices,1.f);
+  if (hasTexcoords) mesh.texcoords.resize(2*numVertices);
+  float colorScale[4];
+  for (int i = 0; i < 4; i++)
+    colorScale[i] = color[i] >= 0 ? plyColorScale(vertices->properties[color[i]].type) : 1.f;
+  /*! stores the property values of vertex #i */
+  auto storeVertex = [&](size_t i, const double *values) {
+    for (int k = 0; k < 3; k++) mesh.positions[3*i+k] = float(values[position[k]]);
+    if (hasNormals)
+      for (int k = 0; k < 3; k++) mesh.normals[3*i+k] = float(values[normal[k]]);
+    if (hasColors)
+      for (int k = 0; k < 4; k++)
+        if (color[k] >= 0) mesh.colors[4*i+k] = float(values[color[k]])*colorScale[k];
+    if (hasTexcoords)
+      for (int k = 0; k < 2; k++) mesh.texcoords[2*i+k] = float(values[texcoord[k]]);
+  };
+  /*! fan triangulates one face */
+  auto addFace = [](std::vector<int> &indices, const int *polygon, size_t n) {
+    for (size_t i = 2; i < n; i++) {
+      indices.push_back(polygon[0]);
+      indices.push_back(polygon[i-1]);
+      indices.push_back(polygon[i]);
+    }
+  };
+  auto isFaceIndices = [](const PLYProperty &p) {
+    return p.countType && (p.name == "vertex_indices" || p.name == "vertex_index");
+  };
+
+  if (format != ASCII) {
+    const uint16_t one = 1;
+    const bool bigEndianHost = *(const uint8_t *)&one == 0;
+    const bool swap = (format == BIG_ENDIAN_BINARY) != bigEndianHost;
+    const unsigned char *p = (const unsigned char *)body, *end = file.data+file.size;
+    for (auto &e : elements) {
+      if (!e.hasLists()) {
+        size_t recordSize = 0;
+        std::vector<size_t> offsets;
+        for (auto &prop : e.properties) {
+          offsets.push_back(recordSize);
+          recordSize += plyTypeSize(prop.type);
+        }
+        if (size_t(end-p) < e.count*recordSize) error("file too short");
+        if (&e == vertices) {
+          const size_t blockSize = 1<<16;
+          parallelForEach((e.count+blockSize-1)/blockSize,[&](size_t block) {
+              std::vector<double> values(e.properties.size());
+              const size_t blockEnd = std::min(e.count,(block+1)*blockSize);
+              for (size_t i = block*blockSize; i < blockEnd; i++) {
+                const unsigned char *record = p+i*recordSize;
+                for (size_t k = 0; k < values.size(); k++)
+                  values[k] = readPLYScalar(record+offsets[k],e.properties[k].type,swap);
+                storeVertex(i,values.data());
+              }
+            });
+        }
+        p += e.count*recordSize;
+        continue;
+      }
+      // variable sized records have to be walked one by one
+      std::vector<int> polygon;
+      for (size_t i = 0; i < e.count; i++)
+        for (auto &prop : e.properties) {
+          if (!prop.countType) {
+            if (size_t(end-p) < plyTypeSize(prop.type)) error("file too short");
+            p += plyTypeSize(prop.type);
+            continue;
+          }
+          const size_t countSize = plyTypeSize(prop.countType);
+          if (size_t(end-p) < countSize) error("file too short");
+          const double n = readPLYScalar(p,prop.countType,swap);
+          p += countSize;
+          const size_t itemSize = plyTypeSize(prop.type);
+          if (n < 0 || size_t(end-p) < n*itemSize) error("file too short");
+          if (&e == faces && isFaceIndices(prop)) {
+            polygon.resize(size_t(n));
+            for (size_t k = 0; k < polygon.size(); k++)
+              polygon[k] = int(readPLYScalar(p+k*itemSize,prop.type,swap));
+            addFace(mesh.indices,polygon.data(),polygon.size());
+          }
+          p += size_t(n)*itemSize;
+        }
+    }
+    return;
+  }
+
+  // ascii: one record per line; count the lines of each chunk first
+  const std::vector<const char *> chunks = splitLines(body,fileEnd);
+  const size_t numChunks = chunks.size()-1;
+  std::vector<size_t> firstLine(numChunks+1,0);
+  parallelForEach(numChunks,[&](size_t chunk) {
+      size_t numLines = std::count(chunks[chunk],chunks[chunk+1],'\n');
+      if (chunks[chunk+1] > chunks[chunk] && chunks[chunk+1][-1] != '\n') numLines++;
+      firstLine[chunk+1] = numLines;
+    });
+  for (size_t i = 0; i < numChunks; i++)
+    firstLine[i+1] += firstLine[i];
+  std::vector<size_t> elementLine(elements.size()+1,0);
+  for (size_t i = 0; i < elements.size(); i++)
+    elementLine[i+1] = elementLine[i]+elements[i].count;
+  if (firstLine[numChunks] < elementLine[elements.size()]) error("file too short");
+
+  std::vector<std::vector<int>> indices(numChunks);
+  parallelForEach(numChunks,[&](size_t chunk) {
+      std::vector<double> values;
+      std::vector<int>    polygon;
+      size_t e = 0, lineNo = firstLine[chunk];
+      for (TextScanner line = { chunks[chunk], chunks[chunk+1] };
+           line.p < line.end; line.nextLine(), lineNo++) {
+        while (e < elements.size() && lineNo >= elementLine[e+1]) e++;
+        if (e == elements.size()) break;
+        const PLYElement &element = elements[e];
+        if (&element == vertices) {
+          values.resize(element.properties.size());
+          for (auto &v : values) {
+            float f;
+            if (!line.parseFloat(f)) error("invalid vertex in line "+std::to_string(lineNo));
+            v = f;
+          }
+          storeVertex(lineNo-elementLine[e],values.data());
+        } else if (&element == faces) {
+          for (auto &prop : element.properties) {
+            int n = 1;
+            if (prop.countType && (!line.parseInt(n) || n < 0))
+              error("invalid face in line "+std::to_string(lineNo));
+            if (isFaceIndices(prop)) {
+              polygon.resize(n);
+              for (auto &i : polygon)
+                if (!line.parseInt(i)) error("invalid face in line "+std::to_string(lineNo));
+              addFace(indices[chunk],polygon.data(),polygon.size());
+            } else
+              for (float f; n > 0 && line.parseFloat(f); n--);
+          }
+        }
+      }
+    });
+  size_t numIndices = 0;
+  for (auto &i : indices) numIndices += i.size();
+  mesh.indices.reserve(numIndices);
+  for (auto &i : indices) {
+    mesh.indices.insert(mesh.indices.end(),i.begin(),i.end());
+    std::vector<int>().swap(i);
+  }
+}
+
+/*! sets a mesh array (if not empty) as a data parameter of the
+    geometry; ospray copies it. A scene record of the geometry takes
+    the array over, instead of keeping a second copy */
+template<typename T>
+void setMeshArray(OSPGeometry geometry, SceneObject *record, const char *name,
+                  std::vector<T> &values, const char *format)
+{
+  if (values.empty()) return;
+  const DataFormat &df = *findDataFormat(format);
+  OSPData data = ospNewData(values.size()/df.numScalars,df.type,values.data(),0);
+  ospCommit(data);
+  ospSetData(geometry,name,data);
+  ospRelease(data);
+  countBytes(values.size()*sizeof(T));
+  if (!record) return;
+
+  auto dataRecord = std::make_shared<SceneObject>(SceneObject::DATA,format);
+  auto owner = std::make_shared<std::vector<T>>(std::move(values));
+  dataRecord->format    = &df;
+  dataRecord->numItems  = owner->size()/df.numScalars;
+  dataRecord->items     = SceneBlob(owner->data(),owner->size()*sizeof(T),owner);
+  dataRecord->committed = true;
+  SceneParam &param = record->param(name);
+  param.type   = 'o';
+  param.object = dataRecord;
+}
+
+/*! creates and commits a triangles geometry from given mesh; the
+    arrays get copied by ospray. With a (new) scene record for the
+    geometry, that record gets filled in, and the mesh emptied */
+OSPGeometry newMeshGeometry(Mesh &mesh, SceneObject *record = nullptr)
+{
+  OSPGeometry geometry = ospNewGeometry("triangles");
+  setMeshArray(geometry,record,"vertex",mesh.positions,"float3");
+  setMeshArray(geometry,record,"vertex.normal",mesh.normals,"float3");
+  setMeshArray(geometry,record,"vertex.color",mesh.colors,"float4");
+  setMeshArray(geometry,record,"vertex.texcoord",mesh.texcoords,"float2");
+  setMeshArray(geometry,record,"index",mesh.indices,"int3");
+  ospCommit(geometry);
+  if (record)
+    record->committed = true;
+  return geometry;
+}
+
+/*! loads an OBJ or PLY file (told apart by the PLY magic) into a
+    committed triangles geometry. Touches no python objects, so call
+    without the GIL; throws on error */
+OSPGeometry loadMesh(const std::string &fileName, SceneObject *record = nullptr)
+{
+  Mesh mesh;
+  {
+    MappedFile file(fileName);
+    if (file.size >= 4 && !memcmp(file.data,"ply",3) && isspace(file.data[3]))
+      loadPLY(mesh,file,fileName);
+    else
+      loadOBJ(mesh,file,fileName);
+  }
+  if (mesh.indices.empty())
+    throw std::runtime_error("'"+fileName+"' contains no triangles");
+  checkIndices(mesh,fileName);
+  return newMeshGeometry(mesh,record);
+}
+
+
+
+// ##################################################################
+// scene snapshots
+// ##################################################################
+
+/*! a scene file is this header, then the raw arrays (data items,
+    instance transforms, voxel regions), each starting at a multiple
+    of 'pageSize', then the object table at 'tableOffset'. The table
+    is the number of objects; each object in an order where objects
+    come after everything they reference (as kind, committed, type,
+    parameters, and a kind-specific part: see writeSceneObject); and
+    finally the indices of the root objects. All in native byte
+    order, which 'byteOrder' tells */
+struct SceneFileHeader {
+  char     magic[8];      // "OSPSCENE"
+  uint32_t version;
+  uint32_t byteOrder;     // 0x01020304
+  uint64_t pageSize;
+  uint64_t tableOffset;
+  uint64_t tableBytes;
+  uint64_t fileBytes;
+};
+
+static const char     sceneMagic[8]  = { 'O','S','P','S','C','E','N','E' };
+static const uint32_t sceneVersion   = 1;
+static const uint32_t sceneByteOrder = 0x01020304;
+static const uint64_t scenePageSize  = 4096;
+
+/*! the object table of a scene file being written, and the arrays
+    that go before it */
+struct SceneWriter {
+  std::string                                      table;
+  std::vector<std::pair<uint64_t,const SceneBlob*>> blobs;
+  uint64_t                                         end { scenePageSize };
+  std::unordered_map<const SceneObject*,uint64_t>  index;
+  /*! keeps the records alive until the file is written */
+  std::vector<std::shared_ptr<SceneObject>>        order;
+
+  template<typename T> void put(const T &value)
+  { table.append((const char *)&value,sizeof(T)); }
+  void put(const std::string &string)
+  { put<uint32_t>(string.size()); table.append(string); }
+  void putObject(const std::shared_ptr<SceneObject> &object)
+  { put<uint64_t>(index.at(object.get())); }
+  void putObjects(const std::vector<std::shared_ptr<SceneObject>> &objects)
+  {
+    put<uint64_t>(objects.size());
+    for (auto &object : objects) putObject(object);
+  }
+  /*! reserves a page-aligned spot for the blob's bytes */
+  void putBlob(const SceneBlob &blob)
+  {
+    blobs.push_back({ end, &blob });
+    put<uint64_t>(end);
+    put<uint64_t>(blob.numBytes);
+    end = (end+blob.numBytes+scenePageSize-1)/scenePageSize*scenePageSize;
+  }
+
+  void add(const std::shared_ptr<SceneObject> &object);
+  void write(const SceneObject &object);
+  /*! writes header, arrays and table; returns the file size */
+  uint64_t writeFile(const std::string &fileName) const;
+};
+
+/*! appends 'object' to the order, after everything it references;
+    throws if it can't be saved */
+void SceneWriter::add(const std::shared_ptr<SceneObject> &object)
+{
+  if (index.count(object.get())) {
+    if (index[object.get()] == ~uint64_t(0))
+      throw std::runtime_error("the objects reference each other in a cycle");
+    return;
+  }
+  static const char *kindNames[SceneObject::NUM_KINDS] = {
+    "camera", "renderer", "light", "model", "geometry", "data", "volume",
+    "transfer function", "instance", "instances"
+  };
+  if (!object->unsavable.empty())
+    throw std::runtime_error(std::string(kindNames[object->kind])+" '"+object->type
+                             +"' cannot be saved: "+object->unsavable);
+  index[object.get()] = ~uint64_t(0);
+  for (auto &param : object->params)
+    if (param.object) add(param.object);
+  for (auto &member : object->members) add(member);
+  for (auto &element : object->elements) add(element);
+  index[object.get()] = order.size();
+  order.push_back(object);
+}
+
+void SceneWriter::write(const SceneObject &object)
+{
+  put<uint32_t>(object.kind);
+  put<uint8_t>(object.committed);
+  put(object.type);
+  put<uint32_t>(object.params.size());
+  for (auto &param : object.params) {
+    put(param.name);
+    put<uint8_t>(param.type);
+    put<uint8_t>(param.count);
+    switch (param.type) {
+    case 'i': table.append((const char *)param.ints,param.count*sizeof(int)); break;
+    case 'f': table.append((const char *)param.floats,param.count*sizeof(float)); break;
+    case 'b': put<uint8_t>(param.ints[0]); break;
+    case 's': put(param.string); break;
+    default : putObject(param.object); break;
+    }
+  }
+  switch (object.kind) {
+  case SceneObject::MODEL:
+    putObjects(object.members);
+    break;
+  case SceneObject::INSTANCE:
+  case SceneObject::INSTANCES:
+    putObject(object.members[0]);
+    putBlob(object.transforms);
+    break;
+  case SceneObject::DATA:
+    put<uint64_t>(object.numItems);
+    if (object.format->scalar == 'P')
+      putObjects(object.elements);
+    else
+      putBlob(object.items);
+    break;
+  case SceneObject::VOLUME:
+    put<uint64_t>(object.regions.size());
+    for (auto &region : object.regions) {
+      put(region.start);
+      put(region.size);
+      putBlob(region.voxels);
+    }
+    break;
+  default:
+    break;
+  }
+}
+
+uint64_t SceneWriter::writeFile(const std::string &fileName) const
+{
+  // into a temporary file first, so an existing scene file stays
+  // intact if anything goes wrong
+  const std::string tmpName = fileName+".tmp";
+  FILE *file = fopen(tmpName.c_str(),"wb");
+  if (!file)
+    throw std::runtime_error("cannot open '"+tmpName+"' for writing: "+strerror(errno));
+
+  static const char zeros[scenePageSize] = {};
+  uint64_t pos = 0;
+  bool ok = true;
+  auto writeAt = [&](uint64_t offset, const void *bytes, size_t numBytes) {
+    for (; ok && pos < offset; ) {
+      const size_t n = std::min<uint64_t>(offset-pos,sizeof(zeros));
+      ok = fwrite(zeros,1,n,file) == n;
+      pos += n;
+    }
+    ok = ok && fwrite(bytes,1,numBytes,file) == numBytes;
+    pos += numBytes;
+  };
+
+  SceneFileHeader header;
+  memcpy(header.magic,sceneMagic,sizeof(sceneMagic));
+  header.version     = sceneVersion;
+  header.byteOrder   = sceneByteOrder;
+  header.pageSize    = scenePageSize;
+  header.tableOffset = end;
+  header.tableBytes  = table.size();
+  header.fileBytes   = end+table.size();
+  writeAt(0,&header,sizeof(header));
+  for (auto &blob : blobs) {
+    writeAt(blob.first,blob.second->bytes,blob.second->numBytes);
+    countBytes(blob.second->numBytes);
+  }
+  writeAt(end,table.data(),table.size());
+  ok = (fclose(file) == 0) && ok;
+  if (!ok || rename(tmpName.c_str(),fileName.c_str()) != 0) {
+    const int error = errno;
+    remove(tmpName.c_str());
+    throw std::runtime_error("cannot write '"+fileName+"': "+strerror(error));
+  }
+  return header.fileBytes;
+}
+
+/*! reads the object table of a scene file; throws if the file ends
+    early or references anything that isn't there */
+struct SceneReader {
+  std::shared_ptr<MappedFile> file;
+  const unsigned char        *pos;
+  const unsigned char        *end;
+  uint64_t                    blobsEnd;
+  std::vector<std::shared_ptr<SceneObject>> objects;
+
+  void need(size_t numBytes)
+  {
+    if (size_t(end-pos) < numBytes)
+      throw std::runtime_error("scene file is truncated");
+  }
+  template<typename T> T get()
+  {
+    T value;
+    need(sizeof(T));
+    memcpy(&value,pos,sizeof(T));
+    pos += sizeof(T);
+    return value;
+  }
+  std::string getString()
+  {
+    const uint32_t size = get<uint32_t>();
+    need(size);
+    std::string string((const char *)pos,size);
+    pos += size;
+    return string;
+  }
+  /*! objects only ever reference objects before them */
+  std::shared_ptr<SceneObject> getObject()
+  {
+    const uint64_t index = get<uint64_t>();
+    if (index >= objects.size())
+      throw std::runtime_error("scene file references object #"+std::to_string(index)
+                               +" out of order");
+    return objects[index];
+  }
+  std::vector<std::shared_ptr<SceneObject>> getObjects()
+  {
+    const uint64_t count = get<uint64_t>();
+    need(count*sizeof(uint64_t));
+    std::vector<std::shared_ptr<SceneObject>> result;
+    for (uint64_t i = 0; i < count; i++)
+      result.push_back(getObject());
+    return result;
+  }
+  /*! an array in the mapped file; shares the mapping */
+  SceneBlob getBlob()
+  {
+    const uint64_t offset = get<uint64_t>(), numBytes = get<uint64_t>();
+    if (offset > blobsEnd || numBytes > blobsEnd-offset)
+      throw std::runtime_error("scene file array is out of bounds");
+    return SceneBlob(file->data+offset,numBytes,file);
+  }
+
+  SceneReader(const std::string &fileName);
+  std::shared_ptr<SceneObject> readObject();
+};
+
+SceneReader::SceneReader(const std::string &fileName)
+  : file(std::make_shared<MappedFile>(fileName))
+{
+  SceneFileHeader header;
+  if (file->size < sizeof(header))
+    throw std::runtime_error("'"+fileName+"' is not a scene file");
+  memcpy(&header,file->data,sizeof(header));
+  if (memcmp(header.magic,sceneMagic,sizeof(sceneMagic)))
+    throw std::runtime_error("'"+fileName+"' is not a scene file");
+  if (header.version != sceneVersion)
+    throw std::runtime_error("'"+fileName+"' has scene file version "
+                             +std::to_string(header.version)+", expected "
+                             +std::to_string(sceneVersion));
+  if (header.byteOrder != sceneByteOrder)
+    throw std::runtime_error("'"+fileName+"' was written on a machine of different byte order");
+  if (header.fileBytes != file->size || header.tableOffset > file->size
+      || header.tableBytes != file->size-header.tableOffset)
+    throw std::runtime_error("'"+fileName+"' is truncated");
+  pos      = file->data+header.tableOffset;
+  end      = pos+header.tableBytes;
+  blobsEnd = header.tableOffset;
+}
+
+std::shared_ptr<SceneObject> SceneReader::readObject()
+{
+  const uint32_t kind = get<uint32_t>();
+  if (kind >= SceneObject::NUM_KINDS)
+    throw std::runtime_error("unknown object kind "+std::to_string(kind)+" in scene file");
+  const bool committed = get<uint8_t>();
+  auto object = std::make_shared<SceneObject>((SceneObject::Kind)kind,getString());
+  object->committed = committed;
+
+  const uint32_t numParams = get<uint32_t>();
+  for (uint32_t i = 0; i < numParams; i++) {
+    SceneParam &param = object->param(getString());
+    param.type  = get<uint8_t>();
+    param.count = get<uint8_t>();
+    if (param.count < 1 || param.count > 4)
+      throw std::runtime_error("invalid parameter '"+param.name+"' in scene file");
+    switch (param.type) {
+    case 'i':
+      need(param.count*sizeof(int));
+      memcpy(param.ints,pos,param.count*sizeof(int));
+      pos += param.count*sizeof(int);
+      break;
+    case 'f':
+      need(param.count*sizeof(float));
+      memcpy(param.floats,pos,param.count*sizeof(float));
+      pos += param.count*sizeof(float);
+      break;
+    case 'b': param.ints[0] = get<uint8_t>(); break;
+    case 's': param.string = getString(); break;
+    case 'o': param.object = getObject(); break;
+    default:
+      throw std::runtime_error("invalid parameter '"+param.name+"' in scene file");
+    }
+  }
+
+  switch (object->kind) {
+  case SceneObject::MODEL:
+    object->members = getObjects();
+    for (auto &member : object->members)
+      if (member->kind != SceneObject::GEOMETRY && member->kind != SceneObject::INSTANCE
+          && member->kind != SceneObject::INSTANCES && member->kind != SceneObject::VOLUME)
+        throw std::runtime_error("scene file adds a non-geometry to a model");
+    break;
+  case SceneObject::INSTANCE:
+  case SceneObject::INSTANCES:
+    object->members.push_back(getObject());
+    object->transforms = getBlob();
+    if (object->members[0]->kind != SceneObject::MODEL
+        || object->transforms.numBytes % sizeof(osp::affine3f)
+        || (object->kind == SceneObject::INSTANCE
+            && object->transforms.numBytes != sizeof(osp::affine3f)))
+      throw std::runtime_error("invalid instance in scene file");
+    break;
+  case SceneObject::DATA:
+    object->format   = findDataFormat(object->type);
+    object->numItems = get<uint64_t>();
+    if (!object->format)
+      throw std::runtime_error("unknown data format '"+object->type+"' in scene file");
+    if (object->format->scalar == 'P') {
+      object->elements = getObjects();
+      if (object->elements.size() != object->numItems)
+        throw std::runtime_error("invalid object array in scene file");
+    } else {
+      object->items = getBlob();
+      if (object->items.numBytes
+          != object->numItems*object->format->numScalars*scalarSize(*object->format))
+        throw std::runtime_error("invalid data array in scene file");
+    }
+    break;
+  case SceneObject::VOLUME: {
+    // ospSetRegion reads size.x*size.y*size.z voxels of 'voxelType'
+    std::string voxelType;
+    for (auto &param : object->params)
+      if (param.name == "voxelType" && param.type == 's')
+        voxelType = param.string;
+    const uint64_t numRegions = get<uint64_t>();
+    for (uint64_t i = 0; i < numRegions; i++) {
+      SceneObject::Region region;
+      region.start  = get<osp::vec3i>();
+      region.size   = get<osp::vec3i>();
+      region.voxels = getBlob();
+      const osp::vec3i &size = region.size;
+      if (size.x < 0 || size.y < 0 || size.z < 0
+          || uint64_t(size.x)*uint64_t(size.y)*uint64_t(size.z)*voxelSize(voxelType)
+             != region.voxels.numBytes)
+        throw std::runtime_error("invalid volume region in scene file");
+      object->regions.push_back(region);
+    }
+  } break;
+  default:
+    break;
+  }
+  return object;
+}
+
+/*! creates (and commits, if the recorded object was committed) the
+    ospray objects for the records, in order; returns their handles
+    (null for INSTANCES, which aren't objects of their own). Arrays
+    get shared with ospray, straight from where the records have them.
+    Doesn't need the GIL */
+std::vector<OSPObject> instantiateScene(const std::vector<std::shared_ptr<SceneObject>> &objects)
+{
+  std::vector<OSPObject> handles;
+  std::unordered_map<const SceneObject*,OSPObject> handleOf;
+  auto releaseAll = [&]() { for (auto handle : handles) if (handle) ospRelease(handle); };
+  try {
+    for (auto &record : objects) {
+      const SceneObject &object = *record;
+      const char *type = object.type.c_str();
+      OSPObject handle = nullptr;
+      switch (object.kind) {
+      case SceneObject::CAMERA:            handle = ospNewCamera(type);           break;
+      case SceneObject::RENDERER:          handle = ospNewRenderer(type);         break;
+      case SceneObject::LIGHT:             handle = ospNewLight3(type);           break;
+      case SceneObject::MODEL:             handle = ospNewModel();                break;
+      case SceneObject::GEOMETRY:          handle = ospNewGeometry(type);         break;
+      case SceneObject::VOLUME:            handle = ospNewVolume(type);           break;
+      case SceneObject::TRANSFER_FUNCTION: handle = ospNewTransferFunction(type); break;
+      case SceneObject::INSTANCE:
+        handle = ospNewInstance((OSPModel)handleOf.at(object.members[0].get()),
+                                *(const osp::affine3f *)object.transforms.bytes);
+        break;
+      case SceneObject::DATA:
+        if (object.format->scalar == 'P') {
+          std::vector<OSPObject> elements;
+          for (auto &element : object.elements)
+            elements.push_back(handleOf.at(element.get()));
+          handle = ospNewData(object.numItems,object.format->type,elements.data(),0);
+        } else
+          handle = ospNewData(object.numItems,object.format->type,object.items.bytes,
+                              OSP_DATA_SHARED_BUFFER);
+        break;
+      default:
+        break;
+      }
+      if (!handle && object.kind != SceneObject::INSTANCES)
+        throw std::runtime_error("ospray could not create '"+object.type+"' object");
+      handles.push_back(handle);
+      handleOf[&object] = handle;
+      if (!handle) continue;
+
+      for (auto &param : object.params) {
+        const char *name = param.name.c_str();
+        switch (param.type) {
+        case 'i':
+          switch (param.count) {
+          case 1: ospSet1i(handle,name,param.ints[0]); break;
+          case 2: ospSet2iv(handle,name,param.ints);   break;
+          case 3: ospSet3iv(handle,name,param.ints);   break;
+          case 4: ospSet4iv(handle,name,param.ints);   break;
+          }
+          break;
+        case 'f':
+          switch (param.count) {
+          case 1: ospSet1f(handle,name,param.floats[0]); break;
+          case 2: ospSet2fv(handle,name,param.floats);   break;
+          case 3: ospSet3fv(handle,name,param.floats);   break;
+          case 4: ospSet4fv(handle,name,param.floats);   break;
+          }
+          break;
+        case 'b': ospSet1b(handle,name,param.ints[0]);            break;
+        case 's': ospSetString(handle,name,param.string.c_str()); break;
+        default:
+          if (param.object->kind == SceneObject::DATA)
+            ospSetData(handle,name,(OSPData)handleOf.at(param.object.get()));
+          else
+            ospSetObject(handle,name,handleOf.at(param.object.get()));
+          break;
+        }
+      }
+      for (auto &member : object.members) {
+        if (object.kind != SceneObject::MODEL) break;
+        if (member->kind == SceneObject::VOLUME)
+          ospAddVolume((OSPModel)handle,(OSPVolume)handleOf.at(member.get()));
+        else if (member->kind == SceneObject::INSTANCES) {
+          OSPModel prototype = (OSPModel)handleOf.at(member->members[0].get());
+          const osp::affine3f *transforms = (const osp::affine3f *)member->transforms.bytes;
+          const size_t numInstances = member->transforms.numBytes/sizeof(osp::affine3f);
+          for (size_t i = 0; i < numInstances; i++) {
+            OSPGeometry instance = ospNewInstance(prototype,transforms[i]);
+            ospAddGeometry((OSPModel)handle,instance);
+            ospRelease(instance);
+          }
+        } else
+          ospAddGeometry((OSPModel)handle,(OSPGeometry)handleOf.at(member.get()));
+      }
+      for (auto &region : object.regions)
+        if (!ospSetRegion((OSPVolume)handle,(void*)region.voxels.bytes,region.start,region.size))
+          throw std::runtime_error("ospSetRegion failed for volume '"+object.type+"'");
+      if (object.committed)
+        ospCommit(handle);
+    }
+  } catch (...) {
+    releaseAll();
+    throw;
+  }
+  return handles;
+}
+
+
+// ##################################################################
+// actual API functions
+// ##################################################################
+
+
+// ==================================================================
+// misc
+// ==================================================================
+
+// ------------------------------------------------------------------
+// ospInit
+// ------------------------------------------------------------------
+extern "C" PyObject *ospray_init(PyObject *self, PyObject *args)
+{
+  ospInit(0,nullptr);
+  Py_INCREF(Py_None);
+  return Py_None;
+}
+
+// ------------------------------------------------------------------
+// ospShutdown
+// ------------------------------------------------------------------
+extern "C" PyObject *ospray_shutdown(PyObject *self, PyObject *args)
+{
+  // finish frames still queued by ospRenderFrameAsync first
+  std::vector<std::string> saveErrors;
+  Py_BEGIN_ALLOW_THREADS
+  renderWorker->waitIdle();
+  saveErrors = saveQueue->flush();
+  Py_END_ALLOW_THREADS
+  dataCache.clear();
+  drainReleases();
+  dependencies.clear();
+  frameSinks.clear();
+  ospShutdown();
+  sharedDataMemory.clear();
+  sceneObjects.clear();
+  sceneFiles.clear();
+  // shut down all the same, but don't lose failed saves silently
+  if (raiseSaveErrors("ospShutdown",saveErrors))
+    return NULL;
+  Py_INCREF(Py_None);
+  return Py_None;
+}
+
+// ------------------------------------------------------------------
+// ospCommit
+// ------------------------------------------------------------------
+extern "C" PyObject *ospray_commit(PyObject *self, PyObject *const *args, Py_ssize_t nargs)
+{
+  // arguments:
+  OSPObject object;
+  if (!checkNumArgs("ospCommit",nargs,1)
+      || !parseHandleArg(args[0],object)) 
+    return NULL;
+  drainReleases();
+  // may build BVHs etc; don't block other python threads meanwhile
+  Py_BEGIN_ALLOW_THREADS
+  ospCommit((OSPObject)object);
+  Py_END_ALLOW_THREADS
+  recordCommit(object);
+  Py_INCREF(Py_None);
+  return Py_None;
+}
+
+// ------------------------------------------------------------------
+// ospAddGeometry
+// ------------------------------------------------------------------
+extern "C" PyObject *ospray_addGeometry(PyObject *self, PyObject *args)
+{
+  // arguments:
+  OSPObject model;
+  OSPObject geom;
+  if (!PyArg_ParseTuple(args, "O&O&", parseHandle, &model, parseHandle, &geom)) 
+    return NULL;
+  ospAddGeometry((OSPModel)model,(OSPGeometry)geom);
+  dependencies.add(geom,model);
+  recordMember(model,geom);
+  Py_INCREF(Py_None);
+  return Py_None;
+}
+
+// ------------------------------------------------------------------
+// ospAddVolume
+// ------------------------------------------------------------------
+extern "C" PyObject *ospray_addVolume(PyObject *self, PyObject *args)
+{
+  // arguments:
+  OSPObject model;
+  OSPObject volume;
+  if (!PyArg_ParseTuple(args, "O&O&", parseHandle, &model, parseHandle, &volume)) 
+    return NULL;
+  ospAddVolume((OSPModel)model,(OSPVolume)volume);
+  dependencies.add(volume,model);
+  recordMember(model,volume);
+  Py_INCREF(Py_None);
+  return Py_None;
+}
+
+// ------------------------------------------------------------------
+// ospRelease
+// ------------------------------------------------------------------
+extern "C" PyObject *ospray_release(PyObject *self, PyObject *args)
+{
+  // arguments:
+  OSPObject object;
+  if (!PyArg_ParseTuple(args, "O&", parseHandle, &object)) 
+    return NULL;
+  releaseObject(object);
+  drainReleases();
+  Py_INCREF(Py_None);
+  return Py_None;
+}
+
+// ------------------------------------------------------------------
+// ospFrameBufferClear
+// ------------------------------------------------------------------
+extern "C" PyObject *ospray_frameBufferClear(PyObject *self, PyObject *args)
+{
+  OSPFrameBuffer fb;
+  PyObject   *channelsList;
+  
+  if (!PyArg_ParseTuple(args, "O&O", parseHandle, &fb, &channelsList)) 
+    return NULL;
+
+  uint32_t channels;
+  if (!parseChannelsArg("ospFrameBufferClear",channelsList,channels))
+    return NULL;
+  ospFrameBufferClear(fb,channels);
+  Py_INCREF(Py_None);
+  return Py_None;
+}
+
+// ------------------------------------------------------------------
+// ospFrameBufferSave
+// ------------------------------------------------------------------
+extern "C" PyObject *ospray_frameBufferSave(PyObject *self, PyObject *args,
+                                             PyObject *kwargs)
+{
+  SaveJob job;
+  OSPFrameBuffer fb;
+  OSPFrameBufferChannel channel;
+  if (!parseSaveArgs("ospFrameBufferSave",args,kwargs,job,fb,channel))
+    return NULL;
+
+  // mapping and encoding touch neither python objects nor the
+  // interpreter, so let other python threads run meanwhile
+  std::string error;
+  const void *pixels;
+  Py_BEGIN_ALLOW_THREADS
+  pixels = ospMapFrameBuffer(fb,channel);
+  if (pixels) {
+    try {
+      writeImage(job.fileName,job.fileType,job.size,job.pixelType,pixels,
+                 job.compressionLevel);
+    } catch (const std::exception &e) {
+      error = e.what();
+    }
+    ospUnmapFrameBuffer(pixels,fb);
+  }
+  Py_END_ALLOW_THREADS
+  if (!pixels) {
+    PyErr_SetString(PyExc_RuntimeError,"ospFrameBufferSave: could not map the frame buffer");
+    return NULL;
+  }
+  if (!error.empty()) {
+    PyErr_SetString(PyExc_IOError,("ospFrameBufferSave: "+error).c_str());
+    return NULL;
+  }
+  Py_INCREF(Py_None);
+  return Py_None;
+}
+
+// ------------------------------------------------------------------
+// ospSaveImage(fileName, pixels [, format [, compressionLevel]])
+// ------------------------------------------------------------------
+extern "C" PyObject *ospray_saveImage(PyObject *self, PyObject *args,
+                                      PyObject *kwargs)
+{
+  static char *kwlist[] = {
+    (char*)"fileName", (char*)"pixels", (char*)"format",
+    (char*)"compressionLevel", NULL
+  };
+  const char *fileName;
+  PyObject   *pixelsArg;
+  const char *format = "srgba";
+  int         compressionLevel = Z_DEFAULT_COMPRESSION;
+  if (!PyArg_ParseTupleAndKeywords(args, kwargs, "sO|si", kwlist,
+                                   &fileName, &pixelsArg, &format, &compressionLevel))
+    return NULL;
+
+  Py_buffer view;
+  if (PyObject_GetBuffer(pixelsArg,&view,PyBUF_C_CONTIGUOUS|PyBUF_FORMAT) != 0)
+    return NULL;
+  // same pixel layout as a mapped frame buffer: (height, width, 4)
+  // uint8 or float32 for color, (height, width) float32 for depth
+  ImageFileType fileType;
+  PixelType     pixelType;
+  osp::vec2i    size;
+  try {
+    const std::string formatString = format;
+    if      (formatString == "srgba")   pixelType = PIXEL_SRGBA8;
+    else if (formatString == "rgba8")   pixelType = PIXEL_RGBA8;
+    else if (formatString == "rgba32f") pixelType = PIXEL_RGBA32F;
+    else if (formatString == "depth")   pixelType = PIXEL_DEPTH32F;
+    else throw std::runtime_error("unknown pixel format '"+formatString+"'");
+    const bool   isFloat   = pixelType == PIXEL_RGBA32F || pixelType == PIXEL_DEPTH32F;
+    const int    ndim      = pixelType == PIXEL_DEPTH32F ? 2 : 3;
+    const char  *fmt       = view.format ? view.format : "B";
+    if (*fmt == '@' || *fmt == '=' || *fmt == '<') ++fmt;
+    if (isFloat ? strcmp(fmt,"f") != 0 : (strchr("Bbc",fmt[0]) == nullptr || fmt[1]))
+      throw std::runtime_error(std::string("pixels must be ")
+                               +(isFloat ? "float32" : "uint8")+" for format '"+format+"'");
+    if (view.ndim != ndim || (ndim == 3 && view.shape[2] != 4))
+      throw std::runtime_error(ndim == 3
+                               ? "pixels must have shape (height, width, 4)"
+                               : "pixels must have shape (height, width)");
+    size = { (int)view.shape[1], (int)view.shape[0] };
+    if (compressionLevel < -1 || compressionLevel > 9)
+      throw std::runtime_error("compression level must be in -1..9");
+    fileType = imageFileType(fileName);
+    checkImageFileType(fileType,pixelType);
+  } catch (const std::runtime_error &e) {
+    PyBuffer_Release(&view);
+    PyErr_SetString(PyExc_ValueError,(std::string("ospSaveImage: ")+e.what()).c_str());
+    return NULL;
+  }
+
+  std::string error;
+  Py_BEGIN_ALLOW_THREADS
+  try {
+    writeImage(fileName,fileType,size,pixelType,view.buf,compressionLevel);
+  } catch (const std::exception &e) {
+    error = e.what();
+  }
+  Py_END_ALLOW_THREADS
+  countBytes(view.len);
+  PyBuffer_Release(&view);
+  if (!error.empty()) {
+    PyErr_SetString(PyExc_IOError,("ospSaveImage: "+error).c_str());
+    return NULL;
+  }
+  Py_INCREF(Py_None);
+  return Py_None;
+}
+
+// ------------------------------------------------------------------
+// ospFrameBufferSaveAsync
+// ------------------------------------------------------------------
+extern "C" PyObject *ospray_frameBufferSaveAsync(PyObject *self, PyObject *args,
+                                                  PyObject *kwargs)
+{
+  std::unique_ptr<SaveJob> job(new SaveJob);
+  OSPFrameBuffer fb;
+  OSPFrameBufferChannel channel;
+  if (!parseSaveArgs("ospFrameBufferSaveAsync",args,kwargs,*job,fb,channel))
+    return NULL;
+
+  // copy the pixels so the frame buffer can be rendered into again
+  // right away; encoding and writing happen in the background
+  const void *pixels;
+  Py_BEGIN_ALLOW_THREADS
+  job->pixels.resize(size_t(job->size.x)*job->size.y*pixelSize(job->pixelType));
+  pixels = ospMapFrameBuffer(fb,channel);
+  if (pixels) {
+    memcpy(job->pixels.data(),pixels,job->pixels.size());
+    countBytes(job->pixels.size());
+    ospUnmapFrameBuffer(pixels,fb);
+    saveQueue->push(std::move(job));
+  }
+  Py_END_ALLOW_THREADS
+  if (!pixels) {
+    PyErr_SetString(PyExc_RuntimeError,"ospFrameBufferSaveAsync: could not map the frame buffer");
+    return NULL;
+  }
+  Py_INCREF(Py_None);
+  return Py_None;
+}
+
+// ------------------------------------------------------------------
+// ospFlushSaves
+// ------------------------------------------------------------------
+extern "C" PyObject *ospray_flushSaves(PyObject *self, PyObject *args)
+{
+  std::vector<std::string> errors;
+  Py_BEGIN_ALLOW_THREADS
+  errors = saveQueue->flush();
+  Py_END_ALLOW_THREADS
+  if (raiseSaveErrors("ospFlushSaves",errors))
+    return NULL;
+  Py_INCREF(Py_None);
+  return Py_None;
+}
+
+// ------------------------------------------------------------------
+// ospSetSaveQueue(numThreads, maxInFlight)
+// ------------------------------------------------------------------
+extern "C" PyObject *ospray_setSaveQueue(PyObject *self, PyObject *args)
+{
+  int numThreads, maxInFlight;
+  if (!PyArg_ParseTuple(args, "ii", &numThreads, &maxInFlight)) 
+    return NULL;
+  if (numThreads < 1 || maxInFlight < 1) {
+    PyErr_SetString(PyExc_ValueError,
+                    "ospSetSaveQueue: need at least one thread and one frame in flight");
+    return NULL;
+  }
+  {
+    std::lock_guard<std::mutex> lock(saveQueue->mutex);
+    saveQueue->maxThreads  = numThreads;
+    saveQueue->maxInFlight = maxInFlight;
+  }
+  saveQueue->workAvailable.notify_all();
+  saveQueue->jobDone.notify_all();
+  Py_INCREF(Py_None);
+  return Py_None;
+}
+
+// ------------------------------------------------------------------
+// ospMapFrameBuffer
+// ------------------------------------------------------------------
+extern "C" PyObject *ospray_mapFrameBuffer(PyObject *self, PyObject *args)
+{
+  PyObject   *fbObject;
+  OSPFrameBuffer fb;
+  const char *channelName = "color";
+
+  if (!PyArg_ParseTuple(args, "O|s", &fbObject, &channelName)
+      || !parseHandle(fbObject,&fb)) 
+    return NULL;
+
+  auto it = frameBufferInfos.find((OSPObject)fb);
+  if (it == frameBufferInfos.end()) {
+    PyErr_SetString(PyExc_ValueError,
+                    "ospMapFrameBuffer: not a frame buffer created by ospNewFrameBuffer");
+    return NULL;
+  }
+  const FrameBufferInfo &info = it->second;
+
+  const std::string channel = channelName;
+  OSPFrameBufferChannel ospChannel;
+  int numComponents;
+  char scalar;
+  if (channel == "color") {
+    ospChannel = OSP_FB_COLOR;
+    numComponents = 4;
+    if (info.format == OSP_FB_SRGBA || info.format == OSP_FB_RGBA8)
+      scalar = 'B';
+    else if (info.format == OSP_FB_RGBA32F)
+      scalar = 'f';
+    else {
+      PyErr_SetString(PyExc_ValueError,"ospMapFrameBuffer: frame buffer has no color format");
+      return NULL;
+    }
+  } else if (channel == "depth") {
+    if (!(info.channels & OSP_FB_DEPTH)) {
+      PyErr_SetString(PyExc_ValueError,"ospMapFrameBuffer: frame buffer has no depth channel");
+      return NULL;
+    }
+    ospChannel = OSP_FB_DEPTH;
+    numComponents = 1;
+    scalar = 'f';
+  } else {
+    PyErr_SetString(PyExc_ValueError,
+                    ("ospMapFrameBuffer: cannot map channel '"+channel+"'").c_str());
+    return NULL;
+  }
+
+  MappedFrameBuffer *mapped = PyObject_New(MappedFrameBuffer,&MappedFrameBufferType);
+  if (!mapped)
+    return NULL;
+  mapped->fb         = fb;
+  mapped->fbObject   = fbObject;
+  Py_INCREF(fbObject);
+  mapped->pixels     = ospMapFrameBuffer(fb,ospChannel);
+  mapped->itemsize   = (scalar == 'B') ? sizeof(uint8_t) : sizeof(float);
+  mapped->format[0]  = scalar;
+  mapped->format[1]  = 0;
+  mapped->numExports = 0;
+  mapped->ndim       = (numComponents > 1) ? 3 : 2;
+  mapped->shape[0]   = info.size.y;
+  mapped->shape[1]   = info.size.x;
+  mapped->shape[2]   = numComponents;
+  mapped->strides[2] = mapped->itemsize;
+  mapped->strides[1] = numComponents*mapped->itemsize;
+  mapped->strides[0] = info.size.x*mapped->strides[1];
+  if (!mapped->pixels) {
+    Py_DECREF(mapped);
+    PyErr_SetString(PyExc_RuntimeError,
+                    ("ospMapFrameBuffer: could not map channel '"+channel+"'").c_str());
+    return NULL;
+  }
+  return (PyObject*)mapped;
+}
+
+// ------------------------------------------------------------------
+// ospUnmapFrameBuffer
+// ------------------------------------------------------------------
+extern "C" PyObject *ospray_unmapFrameBuffer(PyObject *self, PyObject *args)
+{
+  PyObject *mapped;
+  if (!PyArg_ParseTuple(args, "O!", &MappedFrameBufferType, &mapped)) 
+    return NULL;
+  return MappedFrameBuffer_unmap((MappedFrameBuffer*)mapped,NULL);
+}
+
+// ------------------------------------------------------------------
+// ospNewFrameRing(name, size, format='srgba', slots=3)
+// ------------------------------------------------------------------
+/*! creates a POSIX shared memory object 'name' holding a ring of
+    'slots' frames of given size and format, for other processes to
+    read rendered frames from without any copy */
+extern "C" PyObject *ospray_newFrameRing(PyObject *self, PyObject *args, PyObject *kwargs)
+{
+  static char *kwlist[] = {
+    (char*)"name", (char*)"size", (char*)"format", (char*)"slots", NULL
+  };
+  const char *name;
+  osp::vec2i  size;
+  const char *formatString = "srgba";
+  int         numSlots     = 3;
+  if (!PyArg_ParseTupleAndKeywords(args, kwargs, "s(ii)|si", kwlist, &name,
+                                   &size.x, &size.y, &formatString, &numSlots))
+    return NULL;
+
+  std::shared_ptr<FrameRing> ring;
+  try {
+    ring = std::make_shared<FrameRing>(name,size,parseFrameBufferFormat(formatString),numSlots);
+  } catch (const std::system_error &e) {
+    PyErr_SetString(e.code() == std::errc::file_exists ? PyExc_FileExistsError : PyExc_OSError,
+                    (std::string("ospNewFrameRing: ")+e.what()).c_str());
+    return NULL;
+  } catch (const std::runtime_error &e) {
+    PyErr_SetString(PyExc_ValueError,(std::string("ospNewFrameRing: ")+e.what()).c_str());
+    return NULL;
+  }
+  FrameRingObject *object = PyObject_New(FrameRingObject,&FrameRingType);
+  if (!object)
+    return NULL;
+  object->ring = new std::shared_ptr<FrameRing>(ring);
+  return (PyObject*)object;
+}
+
+/*! the (open) ring of a FrameRing object, and the frame buffer info
+    it gets used with; sets a python error and returns false if
+    either is invalid, or they don't match */
+bool checkFrameRing(const char *function, PyObject *ringObject, OSPObject fb)
+{
+  if (!((FrameRingObject*)ringObject)->ring) {
+    PyErr_SetString(PyExc_ValueError,(std::string(function)+": frame ring is closed").c_str());
+    return false;
+  }
+  const FrameRing &ring = **((FrameRingObject*)ringObject)->ring;
+  auto it = frameBufferInfos.find(fb);
+  if (it == frameBufferInfos.end()) {
+    PyErr_SetString(PyExc_ValueError,
+                    (std::string(function)+": not a frame buffer created by ospNewFrameBuffer").c_str());
+    return false;
+  }
+  if (!ring.matches(it->second)) {
+    PyErr_SetString(PyExc_ValueError,
+                    (std::string(function)+": frame buffer size or format does not match the frame ring").c_str());
+    return false;
+  }
+  return true;
+}
+
+// ------------------------------------------------------------------
+// ospSetFrameSink(framebuffer, ring)
+// ------------------------------------------------------------------
+/*! makes ospRenderFrame, ospRenderFrameAsync and ospRenderProgressive
+    publish each frame they render into 'framebuffer' to 'ring' (or
+    no longer, for ring = None) */
+extern "C" PyObject *ospray_setFrameSink(PyObject *self, PyObject *args)
+{
+  OSPObject fb;
+  PyObject *ringObject;
+  if (!PyArg_ParseTuple(args, "O&O", parseHandle, &fb, &ringObject))
+    return NULL;
+
+  if (ringObject == Py_None)
+    frameSinks.erase(fb);
+  else if (!PyObject_TypeCheck(ringObject,&FrameRingType)) {
+    PyErr_SetString(PyExc_TypeError,"ospSetFrameSink: expected a FrameRing or None");
+    return NULL;
+  } else if (!checkFrameRing("ospSetFrameSink",ringObject,fb))
+    return NULL;
+  else
+    frameSinks[fb] = *((FrameRingObject*)ringObject)->ring;
+  Py_INCREF(Py_None);
+  return Py_None;
+}
+
+// ------------------------------------------------------------------
+// ospPublishFrame(ring, framebuffer)
+// ------------------------------------------------------------------
+/*! publishes the current color channel of 'framebuffer' to 'ring';
+    returns the frame id */
+extern "C" PyObject *ospray_publishFrame(PyObject *self, PyObject *args)
+{
+  PyObject *ringObject;
+  OSPObject fb;
+  if (!PyArg_ParseTuple(args, "O!O&", &FrameRingType, &ringObject, parseHandle, &fb)
+      || !checkFrameRing("ospPublishFrame",ringObject,fb))
+    return NULL;
+
+  std::shared_ptr<FrameRing> ring = *((FrameRingObject*)ringObject)->ring;
+  uint64_t frameId;
+  Py_BEGIN_ALLOW_THREADS
+  frameId = ring->publish((OSPFrameBuffer)fb);
+  Py_END_ALLOW_THREADS
+  return PyLong_FromUnsignedLongLong(frameId);
+}
+
+// ------------------------------------------------------------------
+// ospRenderFrame
+// ------------------------------------------------------------------
+extern "C" PyObject *ospray_renderFrame(PyObject *self, PyObject *const *args, Py_ssize_t nargs)
+{
+  OSPFrameBuffer fb;
+  OSPRenderer renderer;
+  
+  if (!checkNumArgs("ospRenderFrame",nargs,3)
+      || !parseHandleArg(args[0],fb)
+      || !parseHandleArg(args[1],renderer)) 
+    return NULL;
+
+  uint32_t channels;
+  try {
+    channels = parseChannels(args[2]);
+  } catch (const std::runtime_error &e) {
+    PyErr_SetString(PyExc_TypeError,(std::string("ospRenderFrame: ")+e.what()).c_str());
+    return NULL;
+  }
+  // channel names are parsed above; release the GIL only for the
+  // actual rendering (and publishing)
+  std::shared_ptr<FrameRing> sink = frameSink(fb);
+  float variance;
+  Py_BEGIN_ALLOW_THREADS
+  variance = ospRenderFrame(fb,renderer,channels);
+  if (sink)
+    sink->publish(fb);
+  Py_END_ALLOW_THREADS
+  return PyFloat_FromDouble(variance);
+}
+
+// ------------------------------------------------------------------
+// ospRenderViews(renderer, camera, views, size [, format [, spp [, out]]])
+// ------------------------------------------------------------------
+extern "C" PyObject *ospray_renderViews(PyObject *self, PyObject *args, PyObject *kwargs)
+{
+  static char *kwlist[] = {
+    (char*)"renderer", (char*)"camera", (char*)"views", (char*)"size",
+    (char*)"format", (char*)"spp", (char*)"out", NULL
+  };
+  OSPRenderer renderer;
+  OSPCamera   camera;
+  PyObject   *viewsArg;
+  osp::vec2i  size;
+  const char *formatString = "srgba";
+  int         spp = 0;
+  PyObject   *outArg = Py_None;
+
+  if (!PyArg_ParseTupleAndKeywords(args, kwargs, "O&O&O(ii)|siO", kwlist,
+                                   parseHandle, &renderer, parseHandle, &camera,
+                                   &viewsArg, &size.x, &size.y,
+                                   &formatString, &spp, &outArg)) 
+    return NULL;
+
+  std::vector<float> views;
+  OSPFrameBufferFormat format;
+  try {
+    const std::vector<Py_ssize_t> shape = bufferFloats(viewsArg,views);
+    if ((shape.size() >= 2 && shape.back() != 9) || views.size() % 9)
+      throw std::runtime_error("views: expected shape (N,9) (pos, dir, up)");
+    if (views.empty())
+      throw std::runtime_error("views: no views given");
+    format = parseFrameBufferFormat(formatString);
+    if (format == OSP_FB_NONE)
+      throw std::runtime_error("format 'none' has no pixels");
+    if (size.x <= 0 || size.y <= 0)
+      throw std::runtime_error("invalid size");
+  } catch (const std::runtime_error &e) {
+    PyErr_SetString(PyExc_ValueError,(std::string("ospRenderViews: ")+e.what()).c_str());
+    return NULL;
+  }
+  const bool   isFloat   = format == OSP_FB_RGBA32F;
+  const size_t pixelSize = isFloat ? 4*sizeof(float) : 4;
+  const size_t numViews  = views.size()/9;
+  const size_t numBytes  = numViews*size.x*size.y*pixelSize;
+
+  // output: either the given (N,H,W,4) buffer, or a new bytearray
+  // that gets returned as a memoryview of that shape
+  PyObject *result;
+  Py_buffer outView;
+  if (outArg != Py_None) {
+    if (PyObject_GetBuffer(outArg,&outView,PyBUF_WRITABLE|PyBUF_C_CONTIGUOUS) != 0)
+      return NULL;
+    if ((size_t)outView.len != numBytes) {
+      PyBuffer_Release(&outView);
+      PyErr_SetString(PyExc_ValueError,
+                      ("ospRenderViews: out has "+std::to_string(outView.len)
+                       +" bytes, but the views need "+std::to_string(numBytes)).c_str());
+      return NULL;
+    }
+    result = outArg;
+    Py_INCREF(result);
+  } else {
+    PyObject *bytes = PyByteArray_FromStringAndSize(NULL,numBytes);
+    if (!bytes) return NULL;
+    PyObject *raw = PyMemoryView_FromObject(bytes);
+    Py_DECREF(bytes);
+    if (!raw) return NULL;
+    result = PyObject_CallMethod(raw,"cast","s(nnnn)",isFloat ? "f" : "B",
+                                 (Py_ssize_t)numViews,(Py_ssize_t)size.y,
+                                 (Py_ssize_t)size.x,(Py_ssize_t)4);
+    Py_DECREF(raw);
+    if (!result || PyObject_GetBuffer(result,&outView,PyBUF_WRITABLE|PyBUF_C_CONTIGUOUS) != 0) {
+      Py_XDECREF(result);
+      return NULL;
+    }
+  }
+
+  OSPFrameBuffer fbs[2] = {
+    ospNewFrameBuffer(size,format,OSP_FB_COLOR),
+    ospNewFrameBuffer(size,format,OSP_FB_COLOR)
+  };
+  if (!fbs[0] || !fbs[1]) {
+    if (fbs[0]) ospRelease(fbs[0]);
+    if (fbs[1]) ospRelease(fbs[1]);
+    PyBuffer_Release(&outView);
+    Py_DECREF(result);
+    PyErr_SetString(PyExc_RuntimeError,"ospRenderViews: ospray could not create the frame buffers");
+    return NULL;
+  }
+
+  // don't touch the camera while ospRenderFrameAsync frames may use it
+  Py_BEGIN_ALLOW_THREADS
+  renderWorker->waitIdle();
+  ospSetObject(renderer,"camera",camera);
+  if (spp > 0) ospSet1i(renderer,"spp",spp);
+  ospCommit(renderer);
+  renderViews(renderer,camera,views,fbs,numBytes/numViews,(unsigned char *)outView.buf);
+  Py_END_ALLOW_THREADS
+  ospRelease(fbs[0]);
+  ospRelease(fbs[1]);
+  // the renderer keeps the camera (and spp), and the camera the last
+  // view, just as if set with ospSetObject, ospSet1i and ospSet3fv
+  dependencies.set(renderer,"camera",camera);
+  recordObjectParam(renderer,"camera",camera);
+  if (spp > 0) recordParam(renderer,"spp",&spp,1);
+  const float *lastView = &views[views.size()-9];
+  recordParam(camera,"pos",lastView,  3);
+  recordParam(camera,"dir",lastView+3,3);
+  recordParam(camera,"up", lastView+6,3);
+  countBytes(numBytes);
+  PyBuffer_Release(&outView);
+  return result;
+}
+
+// ------------------------------------------------------------------
+// ospRenderProgressive
+// ------------------------------------------------------------------
+extern "C" PyObject *ospray_renderProgressive(PyObject *self, PyObject *args)
+{
+  OSPFrameBuffer fb;
+  OSPRenderer renderer;
+  PyObject   *channelsList;
+  int         maxFrames;
+  double      targetVariance = 0.;
+  double      timeBudgetMs   = 0.;
+  
+  if (!PyArg_ParseTuple(args, "O&O&Oi|dd", parseHandle, &fb, parseHandle, &renderer,
+                        &channelsList,
+                        &maxFrames, &targetVariance, &timeBudgetMs)) 
+    return NULL;
+  // with no frame rendered, there'd be no variance to report
+  if (maxFrames < 1) {
+    PyErr_SetString(PyExc_ValueError,"ospRenderProgressive: maxFrames must be at least 1");
+    return NULL;
+  }
+
+  uint32_t channels;
+  if (!parseChannelsArg("ospRenderProgressive",channelsList,channels))
+    return NULL;
+
+  // accumulate frames until either the variance estimate (which
+  // ospray only computes for frame buffers with a 'variance'
+  // channel) drops below the target, the time budget is used up, or
+  // we've done maxFrames; a target or budget <= 0 means 'none'
+  int   numFrames = 0;
+  float variance  = 0.f;
+  std::shared_ptr<FrameRing> sink = frameSink(fb);
+  Py_BEGIN_ALLOW_THREADS
+  const auto begin = std::chrono::steady_clock::now();
+  while (numFrames < maxFrames) {
+    variance = ospRenderFrame(fb,renderer,channels);
+    ++numFrames;
+    if (targetVariance > 0. && variance < targetVariance)
+      break;
+    const double elapsedMs
+      = std::chrono::duration<double,std::milli>(std::chrono::steady_clock::now()-begin).count();
+    if (timeBudgetMs > 0. && elapsedMs >= timeBudgetMs)
+      break;
+  }
+  // only the final, accumulated frame gets published
+  if (sink && numFrames)
+    sink->publish(fb);
+  Py_END_ALLOW_THREADS
+  return Py_BuildValue("(if)", numFrames, variance);
+}
+
+
+
+// ------------------------------------------------------------------
+// ospRenderFrameAsync
+// ------------------------------------------------------------------
+extern "C" PyObject *ospray_renderFrameAsync(PyObject *self, PyObject *args)
+{
+  OSPFrameBuffer fb;
+  OSPRenderer renderer;
+  PyObject   *channelsList;
+  
+  if (!PyArg_ParseTuple(args, "O&O&O", parseHandle, &fb, parseHandle, &renderer,
+                        &channelsList)) 
+    return NULL;
+
+  uint32_t channels;
+  try {
+    channels = parseChannels(channelsList);
+  } catch (const std::runtime_error &e) {
+    PyErr_SetString(PyExc_TypeError,(std::string("ospRenderFrameAsync: ")+e.what()).c_str());
+    return NULL;
+  }
+  std::shared_ptr<RenderTask> task = std::make_shared<RenderTask>();
+  task->fb       = fb;
+  task->renderer = renderer;
+  task->channels = channels;
+  task->sink     = frameSink(fb);
+
+  RenderFuture *handle = PyObject_New(RenderFuture,&RenderFutureType);
+  if (!handle)
+    return NULL;
+  handle->task = new std::shared_ptr<RenderTask>(task);
+  renderWorker->push(task);
+  return (PyObject*)handle;
+}
+
+
+
+
+
+// ==================================================================
+// object creation
+// ==================================================================
+
+// ------------------------------------------------------------------
+// ospNewCamera
+// ------------------------------------------------------------------
+extern "C" PyObject *ospray_newCamera(PyObject *self, PyObject *args)
+{
+  const char *typeString = nullptr;
+  if (!PyArg_ParseTuple(args, "s", &typeString)) 
+    return NULL; 
+  OSPCamera camera = ospNewCamera(typeString);
+  recordNew(camera,SceneObject::CAMERA,typeString);
+  drainReleases();
+  return wrapObject(camera,&CameraType);
 }
 
 // ------------------------------------------------------------------
-// ospRelease
-// ------------------------------------------------------------------
-extern "C" PyObject *ospray_release(PyObject *self, PyObject *args)
+// ospNewRenderer
+// ------------------------------------------------------------------
+extern "C" PyObject *ospray_newRenderer(PyObject *self, PyObject *args)
+{
+  const char *typeString = nullptr;
+  if (!PyArg_ParseTuple(args, "s", &typeString)) 
+    return NULL; 
+  OSPRenderer renderer = ospNewRenderer(typeString);
+  recordNew(renderer,SceneObject::RENDERER,typeString);
+  drainReleases();
+  return wrapObject(renderer,&RendererType);
+}
+
+// ------------------------------------------------------------------
+// ospNewLight
+// ------------------------------------------------------------------
+extern "C" PyObject *ospray_newLight(PyObject *self, PyObject *args)
+{
+  const char *typeString = nullptr;
+  if (!PyArg_ParseTuple(args, "s", &typeString)) 
+    return NULL; 
+  OSPLight light = ospNewLight3(typeString);
+  recordNew(light,SceneObject::LIGHT,typeString);
+  drainReleases();
+  return wrapObject(light,&LightType);
+}
+
+
+// ------------------------------------------------------------------
+// ospNewFrameBuffer
+// ------------------------------------------------------------------
+extern "C" PyObject *ospray_newFrameBuffer(PyObject *self, PyObject *args)
+{
+  osp::vec2i size;
+  const char *formatString;
+  PyObject   *channelsList;
+  
+  if (!PyArg_ParseTuple(args, "(ii)sO",
+                        &size.x, &size.y, &formatString, &channelsList)) 
+    return NULL;
+
+  OSPFrameBufferFormat format;
+  try {
+    format = parseFrameBufferFormat(formatString);
+  } catch (const std::runtime_error &e) {
+    PyErr_SetString(PyExc_ValueError,e.what());
+    return NULL;
+  }
+
+  uint32_t channels;
+  if (!parseChannelsArg("ospNewFrameBuffer",channelsList,channels))
+    return NULL;
+  OSPFrameBuffer fb = ospNewFrameBuffer(size,format,channels);
+  if (fb)
+    frameBufferInfos[(OSPObject)fb] = { size, format, channels };
+  drainReleases();
+  return wrapObject(fb,&FrameBufferType);
+}
+
+
+
+// ------------------------------------------------------------------
+// ospNewModel
+// ------------------------------------------------------------------
+extern "C" PyObject *ospray_newModel(PyObject *self, PyObject *args)
+{
+  OSPModel model = ospNewModel();
+  recordNew(model,SceneObject::MODEL,"model");
+  drainReleases();
+  return wrapObject(model,&ModelType);
+}
+
+// ------------------------------------------------------------------
+// ospNewGeometry
+// ------------------------------------------------------------------
+extern "C" PyObject *ospray_newGeometry(PyObject *self, PyObject *args)
+{
+  const char *typeString = nullptr;
+  if (!PyArg_ParseTuple(args, "s", &typeString)) 
+    return NULL; 
+  OSPGeometry geometry = ospNewGeometry(typeString);
+  recordNew(geometry,SceneObject::GEOMETRY,typeString);
+  drainReleases();
+  return wrapObject(geometry,&GeometryType);
+}
+
+
+// ------------------------------------------------------------------
+// ospNewVolume
+// ------------------------------------------------------------------
+extern "C" PyObject *ospray_newVolume(PyObject *self, PyObject *args)
+{
+  const char *typeString = nullptr;
+  if (!PyArg_ParseTuple(args, "s", &typeString)) 
+    return NULL; 
+  OSPVolume volume = ospNewVolume(typeString);
+  recordNew(volume,SceneObject::VOLUME,typeString);
+  drainReleases();
+  return wrapObject(volume,&VolumeType);
+}
+
+// ------------------------------------------------------------------
+// ospNewTransferFunction
+// ------------------------------------------------------------------
+extern "C" PyObject *ospray_newTransferFunction(PyObject *self, PyObject *args)
+{
+  const char *typeString = nullptr;
+  if (!PyArg_ParseTuple(args, "s", &typeString)) 
+    return NULL; 
+  OSPTransferFunction transferFunction = ospNewTransferFunction(typeString);
+  recordNew(transferFunction,SceneObject::TRANSFER_FUNCTION,typeString);
+  drainReleases();
+  return wrapObject(transferFunction,&TransferFunctionType);
+}
+
+// ------------------------------------------------------------------
+// ospLoadMesh(fileName)
+// ------------------------------------------------------------------
+extern "C" PyObject *ospray_loadMesh(PyObject *self, PyObject *args)
+{
+  const char *fileName;
+  if (!PyArg_ParseTuple(args, "s", &fileName)) 
+    return NULL;
+
+  // the record isn't known to anyone else until it's registered below,
+  // so it can get filled in without the GIL
+  std::shared_ptr<SceneObject> record;
+  if (sceneRecording)
+    record = std::make_shared<SceneObject>(SceneObject::GEOMETRY,"triangles");
+
+  OSPGeometry geometry = nullptr;
+  std::string error;
+  Py_BEGIN_ALLOW_THREADS
+  try {
+    geometry = loadMesh(fileName,record.get());
+  } catch (const std::exception &e) {
+    error = e.what();
+  }
+  Py_END_ALLOW_THREADS
+  if (!error.empty()) {
+    PyErr_SetString(PyExc_IOError,("ospLoadMesh: "+error).c_str());
+    return NULL;
+  }
+  if (record)
+    sceneObjects[(OSPObject)geometry] = record;
+  drainReleases();
+  return wrapObject(geometry,&GeometryType);
+}
+
+// ------------------------------------------------------------------
+// ospNewInstance(model, transform)
+// ------------------------------------------------------------------
+extern "C" PyObject *ospray_newInstance(PyObject *self, PyObject *const *args, Py_ssize_t nargs)
+{
+  OSPModel model;
+  float    xfm[12];
+  if (!checkNumArgs("ospNewInstance",nargs,2)
+      || !parseHandleArg(args[0],model)
+      || !parseListArg("ospNewInstance",args[1],xfm)) 
+    return NULL;
+
+  const osp::affine3f transform = affineFromColumns(xfm);
+  OSPGeometry instance = ospNewInstance(model,transform);
+  dependencies.add((OSPObject)model,(OSPObject)instance);
+  recordNewInstance(instance,model,transform);
+  drainReleases();
+  return wrapObject(instance,&GeometryType);
+}
+
+// ------------------------------------------------------------------
+// ospAddInstances(model, prototype, transforms)
+// ------------------------------------------------------------------
+extern "C" PyObject *ospray_addInstances(PyObject *self, PyObject *args)
+{
+  OSPObject model, prototype;
+  PyObject *transformsArg;
+  if (!PyArg_ParseTuple(args, "O&O&O", parseHandle, &model, parseHandle, &prototype,
+                        &transformsArg)) 
+    return NULL;
+
+  std::vector<osp::affine3f> transforms;
+  try {
+    transforms = bufferTransforms(transformsArg);
+  } catch (const std::runtime_error &e) {
+    PyErr_SetString(PyExc_ValueError,(std::string("ospAddInstances: transforms: ")+e.what()).c_str());
+    return NULL;
+  }
+  // ospray's object creation and model editing aren't thread safe,
+  // so the instances get created one after the other - but without
+  // any python in between. The model keeps them alive
+  Py_BEGIN_ALLOW_THREADS
+  for (auto &transform : transforms) {
+    OSPGeometry instance = ospNewInstance((OSPModel)prototype,transform);
+    ospAddGeometry((OSPModel)model,instance);
+    ospRelease(instance);
+  }
+  Py_END_ALLOW_THREADS
+  // the instances themselves are the model's now; what changes with
+  // the prototype is the model
+  const size_t numInstances = transforms.size();
+  if (numInstances)
+    dependencies.add(prototype,model);
+  recordInstances(model,prototype,std::move(transforms));
+  drainReleases();
+  return PyLong_FromSize_t(numInstances);
+}
+
+// ------------------------------------------------------------------
+// ospNewData
+// ------------------------------------------------------------------
+extern "C" PyObject *ospray_newData(PyObject *self, PyObject *args, PyObject *kwargs)
+{
+  static char *kwlist[] = {
+    (char*)"numItems", (char*)"format", (char*)"values",
+    (char*)"flags", (char*)"stride", (char*)"offset", NULL
+  };
+  // args:
+  int numItems;
+  const char *formatString;
+  PyObject   *valuesList;
+  unsigned int flags = 0;
+  Py_ssize_t stride = 0, offset = 0;
+  
+  if (!PyArg_ParseTupleAndKeywords(args, kwargs, "isO|Inn", kwlist,
+                                   &numItems, &formatString, &valuesList,
+                                   &flags, &stride, &offset)) 
+    return NULL;
+  if (stride < 0 || offset < 0) {
+    PyErr_SetString(PyExc_ValueError,"ospNewData: stride and offset must not be negative");
+    return NULL;
+  }
+
+  try {
+    if (dataCache.enabled() && dataFormat(formatString).scalar != 'P') {
+      PyObject *data = dataCache.newData(numItems,dataFormat(formatString),valuesList,
+                                         stride,offset);
+      drainReleases();
+      return data;
+    }
+    OSPData data = newData(numItems,formatString,valuesList,flags,stride,offset);
+    drainReleases();
+    return wrapObject(data,&DataType);
+  } catch (const std::overflow_error &e) {
+    PyErr_SetString(PyExc_OverflowError,e.what());
+    return NULL;
+  } catch (const std::runtime_error &e) {
+    PyErr_SetString(PyExc_ValueError,e.what());
+    return NULL;
+  }
+}
+
+// ------------------------------------------------------------------
+// ospDataCache(maxBytes)
+// ------------------------------------------------------------------
+extern "C" PyObject *ospray_dataCache(PyObject *self, PyObject *args)
+{
+  Py_ssize_t maxBytes;
+  if (!PyArg_ParseTuple(args, "n", &maxBytes)) 
+    return NULL;
+  if (maxBytes < 0) {
+    PyErr_SetString(PyExc_ValueError,"ospDataCache: maxBytes must not be negative");
+    return NULL;
+  }
+  dataCache.setMaxBytes(maxBytes);
+  drainReleases();
+  Py_INCREF(Py_None);
+  return Py_None;
+}
+
+// ------------------------------------------------------------------
+// ospDataCacheClear
+// ------------------------------------------------------------------
+extern "C" PyObject *ospray_dataCacheClear(PyObject *self, PyObject *args)
+{
+  dataCache.clear();
+  drainReleases();
+  Py_INCREF(Py_None);
+  return Py_None;
+}
+
+// ------------------------------------------------------------------
+// ospDataCacheStats
+// ------------------------------------------------------------------
+extern "C" PyObject *ospray_dataCacheStats(PyObject *self, PyObject *args)
+{
+  return Py_BuildValue("{s:n,s:n,s:n,s:n,s:n,s:n,s:n}",
+                       "hits",        (Py_ssize_t)dataCache.hits,
+                       "misses",      (Py_ssize_t)dataCache.misses,
+                       "evictions",   (Py_ssize_t)dataCache.evictions,
+                       "entries",     (Py_ssize_t)dataCache.entries.size(),
+                       "bytes",       (Py_ssize_t)dataCache.numBytes,
+                       "max_bytes",   (Py_ssize_t)dataCache.maxBytes,
+                       "bytes_saved", (Py_ssize_t)dataCache.bytesSaved);
+}
+
+// ------------------------------------------------------------------
+// ospUpdateData(data, offset=0, values=None, commit=True)
+// ------------------------------------------------------------------
+/*! writes 'values' over the items of a shared-memory data object,
+    starting at item 'offset', then commits what uses the data (the
+    geometry, its models, the renderer, ...). Without values, the
+    items are taken to have been changed in place already (e.g., in
+    the numpy array the data shares). Returns the number of objects
+    committed */
+extern "C" PyObject *ospray_updateData(PyObject *self, PyObject *args, PyObject *kwargs)
+{
+  static char *kwlist[] = {
+    (char*)"data", (char*)"offset", (char*)"values", (char*)"commit", NULL
+  };
+  OSPObject  data;
+  Py_ssize_t offset = 0;
+  PyObject  *values = Py_None;
+  int        commit = 1;
+  if (!PyArg_ParseTupleAndKeywords(args, kwargs, "O&|nOp", kwlist, parseHandle, &data,
+                                   &offset, &values, &commit))
+    return NULL;
+
+  try {
+    SharedDataMemory &memory = updatableData(data);
+    if (values != Py_None) {
+      Py_buffer view;
+      updateValues(values,memory,view);
+      std::unique_ptr<Py_buffer,void(*)(Py_buffer*)> release(&view,PyBuffer_Release);
+      const size_t itemSize = memory.format->numScalars*scalarSize(*memory.format);
+      const size_t numItems = view.len/itemSize;
+      if (offset < 0 || offset+numItems > memory.numItems)
+        throw std::runtime_error("items ["+std::to_string(offset)+","
+                                 +std::to_string(offset+numItems)+") are outside the "
+                                 +std::to_string(memory.numItems)+" items of the data");
+      // a frame from ospRenderFrameAsync may still read the old items
+      Py_BEGIN_ALLOW_THREADS
+      renderWorker->waitIdle();
+      Py_END_ALLOW_THREADS
+      copyValues(view,memory.items()+offset*itemSize);
+      countBytes(view.len);
+    }
+  } catch (const std::runtime_error &e) {
+    PyErr_SetString(PyExc_ValueError,(std::string("ospUpdateData: ")+e.what()).c_str());
+    return NULL;
+  }
+  return PyLong_FromSize_t(commit ? commitDependents(data) : 0);
+}
+
+// ------------------------------------------------------------------
+// ospUpdateDataRanges(data, values, ranges, commit=True)
+// ------------------------------------------------------------------
+/*! like ospUpdateData, but 'values' has all items of the data, and
+    only the dirty ranges - a sequence of (first, count) item pairs -
+    get copied from it */
+extern "C" PyObject *ospray_updateDataRanges(PyObject *self, PyObject *args, PyObject *kwargs)
+{
+  static char *kwlist[] = {
+    (char*)"data", (char*)"values", (char*)"ranges", (char*)"commit", NULL
+  };
+  OSPObject data;
+  PyObject *values, *rangesArg;
+  int       commit = 1;
+  if (!PyArg_ParseTupleAndKeywords(args, kwargs, "O&OO|p", kwlist, parseHandle, &data,
+                                   &values, &rangesArg, &commit))
+    return NULL;
+
+  // reused from call to call, so per-frame updates don't allocate
+  static thread_local std::vector<std::pair<size_t,size_t>> ranges;
+  try {
+    SharedDataMemory &memory = updatableData(data);
+    Py_buffer view;
+    updateValues(values,memory,view);
+    std::unique_ptr<Py_buffer,void(*)(Py_buffer*)> release(&view,PyBuffer_Release);
+    const size_t itemSize = memory.format->numScalars*scalarSize(*memory.format);
+    if ((size_t)view.len != memory.numItems*itemSize)
+      throw std::runtime_error("values have "+std::to_string(view.len/itemSize)
+                               +" items, but the data has "+std::to_string(memory.numItems));
+    if (!PyBuffer_IsContiguous(&view,'C'))
+      throw std::runtime_error("values must be a contiguous buffer");
+
+    FastSequence seq(rangesArg);
+    ranges.clear();
+    for (size_t i = 0; i < seq.size(); i++) {
+      long long range[2];
+      convertSequence(seq[i],range,2,getLongLong);
+      if (range[0] < 0 || range[1] < 0 || size_t(range[0]+range[1]) > memory.numItems)
+        throw std::runtime_error("range ("+std::to_string(range[0])+","
+                                 +std::to_string(range[1])+") is outside the "
+                                 +std::to_string(memory.numItems)+" items of the data");
+      ranges.push_back({ size_t(range[0])*itemSize, size_t(range[1])*itemSize });
+    }
+
+    Py_BEGIN_ALLOW_THREADS
+    renderWorker->waitIdle();
+    for (auto &range : ranges)
+      memmove(memory.items()+range.first,(const unsigned char *)view.buf+range.first,
+              range.second);
+    Py_END_ALLOW_THREADS
+    for (auto &range : ranges)
+      countBytes(range.second);
+  } catch (const std::runtime_error &e) {
+    PyErr_SetString(PyExc_ValueError,(std::string("ospUpdateDataRanges: ")+e.what()).c_str());
+    return NULL;
+  }
+  return PyLong_FromSize_t(commit ? commitDependents(data) : 0);
+}
+
+
+
+
+
+
+// ==================================================================
+// 'set' methods
+// ==================================================================
+
+// ------------------------------------------------------------------
+// ospSetObject(OSPObject)
+// ------------------------------------------------------------------
+extern "C" PyObject *ospray_setObject(PyObject *self, PyObject *const *args, Py_ssize_t nargs)
+{
+  // arguments:
+  OSPObject object;
+  const char *varName;
+  OSPObject value;
+  
+  if (!checkNumArgs("ospSetObject",nargs,3)
+      || !parseHandleArg(args[0],object)
+      || !parseArg(args[1],varName)
+      || !parseHandleArg(args[2],value)) 
+    return NULL;
+
+  ospSetObject(object,varName,value);
+  dependencies.set(object,varName,value);
+  recordObjectParam(object,varName,value);
+  Py_INCREF(Py_None);
+  return Py_None;
+}
+
+// ------------------------------------------------------------------
+// ospSetData(OSPData)
+// ------------------------------------------------------------------
+extern "C" PyObject *ospray_setData(PyObject *self, PyObject *const *args, Py_ssize_t nargs)
 {
   // arguments:
   OSPObject object;
-  if (!PyArg_ParseTuple(args, "l", &object)) 
+  const char *varName;
+  OSPData value;
+  
+  if (!checkNumArgs("ospSetData",nargs,3)
+      || !parseHandleArg(args[0],object)
+      || !parseArg(args[1],varName)
+      || !parseHandleArg(args[2],value)) 
     return NULL;
-  ospRelease((OSPObject)object);
+
+  ospSetData(object,varName,value);
+  dependencies.set(object,varName,(OSPObject)value);
+  recordObjectParam(object,varName,(OSPObject)value);
   Py_INCREF(Py_None);
   return Py_None;
 }
 
 // ------------------------------------------------------------------
-// ospFrameBufferClear
+// ospSet1i(int)
+// ------------------------------------------------------------------
+extern "C" PyObject *ospray_set1i(PyObject *self, PyObject *const *args, Py_ssize_t nargs)
+{
+  // arguments:
+  OSPObject object;
+  const char *varName;
+  int value;
+  
+  if (!checkNumArgs("ospSet1i",nargs,3)
+      || !parseHandleArg(args[0],object)
+      || !parseArg(args[1],varName)
+      || !parseArg(args[2],value)) 
+    return NULL;
+
+  ospSet1i(object,varName,value);
+  recordParam(object,varName,&value,1);
+  Py_INCREF(Py_None);
+  return Py_None;
+}
+
+// ------------------------------------------------------------------
+// ospSet1f(float)
+// ------------------------------------------------------------------
+extern "C" PyObject *ospray_set1f(PyObject *self, PyObject *const *args, Py_ssize_t nargs)
+{
+  // arguments:
+  OSPObject object;
+  const char *varName;
+  float value;
+  
+  if (!checkNumArgs("ospSet1f",nargs,3)
+      || !parseHandleArg(args[0],object)
+      || !parseArg(args[1],varName)
+      || !parseArg(args[2],value)) 
+    return NULL;
+
+  ospSet1f(object,varName,value);
+  recordParam(object,varName,&value,1);
+  Py_INCREF(Py_None);
+  return Py_None;
+}
+
+// ------------------------------------------------------------------
+// ospSet1b(bool)
+// ------------------------------------------------------------------
+extern "C" PyObject *ospray_set1b(PyObject *self, PyObject *const *args, Py_ssize_t nargs)
+{
+  // arguments:
+  OSPObject object;
+  const char *varName;
+  
+  if (!checkNumArgs("ospSet1b",nargs,3)
+      || !parseHandleArg(args[0],object)
+      || !parseArg(args[1],varName)) 
+    return NULL;
+  const int value = PyObject_IsTrue(args[2]);
+  if (value < 0)
+    return NULL;
+
+  ospSet1b(object,varName,value);
+  recordParam(object,varName,value != 0);
+  Py_INCREF(Py_None);
+  return Py_None;
+}
+
+// ------------------------------------------------------------------
+// ospSetString(string)
 // ------------------------------------------------------------------
-extern "C" PyObject *ospray_frameBufferClear(PyObject *self, PyObject *args)
+extern "C" PyObject *ospray_setString(PyObject *self, PyObject *const *args, Py_ssize_t nargs)
 {
-  OSPFrameBuffer fb;
-  PyObject   *channelsList;
+  // arguments:
+  OSPObject object;
+  const char *varName;
+  const char *value;
   
-  if (!PyArg_ParseTuple(args, "lO", &fb, &channelsList)) 
+  if (!checkNumArgs("ospSetString",nargs,3)
+      || !parseHandleArg(args[0],object)
+      || !parseArg(args[1],varName)
+      || !parseArg(args[2],value)) 
     return NULL;
 
-  std::vector<std::string> channelStrings = getStrings(channelsList);
-  uint64_t channels = 0;
-  for (auto &channel: channelStrings) {
-    if (channel == "color") channels |= OSP_FB_COLOR;
-    if (channel == "depth") channels |= OSP_FB_DEPTH;
-    if (channel == "accum") channels |= OSP_FB_ACCUM;
-  }
-  ospFrameBufferClear(fb,channels);
+  ospSetString(object,varName,value);
+  recordParam(object,varName,std::string(value));
   Py_INCREF(Py_None);
   return Py_None;
 }
 
 // ------------------------------------------------------------------
-// ospFrameBufferSave
+// ospSetVoidPtr(pointer, as int)
 // ------------------------------------------------------------------
-extern "C" PyObject *ospray_frameBufferSave(PyObject *self, PyObject *args)
+extern "C" PyObject *ospray_setVoidPtr(PyObject *self, PyObject *const *args, Py_ssize_t nargs)
 {
-  char *fileName;
-  OSPFrameBuffer fb;
-  osp::vec2i size;
-  char *format;
+  // arguments:
+  OSPObject object;
+  const char *varName;
+  void *value;
   
-  if (!PyArg_ParseTuple(args, "sl(ii)s",
-                        &fileName, &fb, &size.x, &size.y, &format)) 
+  if (!checkNumArgs("ospSetVoidPtr",nargs,3)
+      || !parseHandleArg(args[0],object)
+      || !parseArg(args[1],varName)
+      || !parseArg(args[2],value)) 
     return NULL;
-  
-  const std::string fn = fileName;
-  size_t dotPos = fn.rfind(".");
-  if (dotPos == std::string::npos)
-    throw std::runtime_error
-      ("invalid image file name '"
-       +fn
-       +"' : cannot determine file format from extension");
-  const uint32_t *pixels
-    = (const uint32_t *)ospMapFrameBuffer(fb,OSP_FB_COLOR);
-  
-  const std::string ext = fn.substr(dotPos);
-  if (ext == ".png" || ext == ".PNG")
-    writePNG(fileName,size,pixels);
-  else if (ext == ".ppm" || ext == ".PPM")
-    writePPM(fileName,size,pixels);
-  else 
-    std::cerr << "invalid/unsupported file name type '"
-              << ext << "'" << std::endl;
-    
-  ospUnmapFrameBuffer(pixels,fb);
+
+  ospSetVoidPtr(object,varName,value);
+  recordUnsavable(object,std::string("parameter '")+varName+"' is a raw pointer");
   Py_INCREF(Py_None);
   return Py_None;
 }
 
-// ------------------------------------------------------------------
-// ospRenderFrame
-// ------------------------------------------------------------------
-extern "C" PyObject *ospray_renderFrame(PyObject *self, PyObject *args)
+/*! shared implementation of all vector setters: the ospSetNf/ospSetNi
+    variants take N separate numbers, the ospSetNfv/ospSetNiv/
+    ospSetVecN variants one list or tuple of N. Either way the values
+    get converted straight into a stack array, and passed on through
+    ospray's pointer variant */
+template<typename T, int N, void (*set)(OSPObject, const char *, const T *)>
+PyObject *setVector(const char *function, bool asList,
+                    PyObject *const *args, Py_ssize_t nargs)
 {
-  OSPFrameBuffer fb;
-  OSPRenderer renderer;
-  PyObject   *channelsList;
-  
-  if (!PyArg_ParseTuple(args, "llO", &fb, &renderer, &channelsList)) 
+  // arguments:
+  OSPObject object;
+  const char *varName;
+  T value[N];
+
+  if (!checkNumArgs(function,nargs,asList ? 3 : 2+N)
+      || !parseHandleArg(args[0],object)
+      || !parseArg(args[1],varName)) 
     return NULL;
+  if (asList) {
+    if (!parseListArg(function,args[2],value))
+      return NULL;
+  } else
+    for (int i = 0; i < N; i++)
+      if (!parseArg(args[2+i],value[i]))
+        return NULL;
 
-  std::vector<std::string> channelStrings = getStrings(channelsList);
-  uint64_t channels = 0;
-  for (auto &channel: channelStrings) {
-    if (channel == "color") channels |= OSP_FB_COLOR;
-    if (channel == "depth") channels |= OSP_FB_DEPTH;
-    if (channel == "accum") channels |= OSP_FB_ACCUM;
-  }
-  ospRenderFrame(fb,renderer,channels);
+  set(object,varName,value);
+  recordParam(object,varName,value,N);
   Py_INCREF(Py_None);
   return Py_None;
 }
 
+#define VECTOR_SETTER(name,ospName,T,N,set,asList)                      \
+  extern "C" PyObject *ospray_##name(PyObject *self, PyObject *const *args, Py_ssize_t nargs) \
+  { return setVector<T,N,set>(ospName,asList,args,nargs); }
+
+// ------------------------------------------------------------------
+// ospSet2f/3f/4f(N floats), ospSet2fv/3fv/4fv(list of N floats)
+// ------------------------------------------------------------------
+VECTOR_SETTER(set2f,"ospSet2f",float,2,ospSet2fv,false)
+VECTOR_SETTER(set3f,"ospSet3f",float,3,ospSet3fv,false)
+VECTOR_SETTER(set4f,"ospSet4f",float,4,ospSet4fv,false)
+VECTOR_SETTER(set2fv,"ospSet2fv",float,2,ospSet2fv,true)
+VECTOR_SETTER(set3fv,"ospSet3fv",float,3,ospSet3fv,true)
+VECTOR_SETTER(set4fv,"ospSet4fv",float,4,ospSet4fv,true)
+
+// ------------------------------------------------------------------
+// ospSet2i/3i/4i(N ints), ospSet2iv/3iv/4iv(list of N ints)
+// ------------------------------------------------------------------
+VECTOR_SETTER(set2i,"ospSet2i",int,2,ospSet2iv,false)
+VECTOR_SETTER(set3i,"ospSet3i",int,3,ospSet3iv,false)
+VECTOR_SETTER(set4i,"ospSet4i",int,4,ospSet4iv,false)
+VECTOR_SETTER(set2iv,"ospSet2iv",int,2,ospSet2iv,true)
+VECTOR_SETTER(set3iv,"ospSet3iv",int,3,ospSet3iv,true)
+VECTOR_SETTER(set4iv,"ospSet4iv",int,4,ospSet4iv,true)
+
+#undef VECTOR_SETTER
+
+
+
+
+
+
+
+
+
+
 
 
 
@@ -353,247 +6135,677 @@ extern "C" PyObject *ospray_renderFrame(PyObject *self, PyObject *args)
 
 
 // ==================================================================
-// object creation
+// volumes
 // ==================================================================
 
 // ------------------------------------------------------------------
-// ospNewCamera
+// ospSetRegion(volume, voxels, regionCoords, regionSize)
 // ------------------------------------------------------------------
-extern "C" PyObject *ospray_newCamera(PyObject *self, PyObject *args)
+extern "C" PyObject *ospray_setRegion(PyObject *self, PyObject *args)
 {
-  const char *typeString = nullptr;
-  if (!PyArg_ParseTuple(args, "s", &typeString)) 
-    return NULL; 
-  OSPCamera camera = ospNewCamera(typeString);
-  return Py_BuildValue("l", (uint64_t)camera);
-}
+  // arguments:
+  OSPVolume  volume;
+  Py_buffer  voxels;
+  osp::vec3i coords, size;
 
-// ------------------------------------------------------------------
-// ospNewRenderer
-// ------------------------------------------------------------------
-extern "C" PyObject *ospray_newRenderer(PyObject *self, PyObject *args)
-{
-  const char *typeString = nullptr;
-  if (!PyArg_ParseTuple(args, "s", &typeString)) 
-    return NULL; 
-  OSPRenderer renderer = ospNewRenderer(typeString);
-  return Py_BuildValue("l", (uint64_t)renderer);
-}
+  if (!PyArg_ParseTuple(args, "O&y*(iii)(iii)", parseHandle, &volume, &voxels,
+                        &coords.x, &coords.y, &coords.z,
+                        &size.x, &size.y, &size.z)) 
+    return NULL;
 
-// ------------------------------------------------------------------
-// ospNewLight
-// ------------------------------------------------------------------
-extern "C" PyObject *ospray_newLight(PyObject *self, PyObject *args)
-{
-  const char *typeString = nullptr;
-  if (!PyArg_ParseTuple(args, "s", &typeString)) 
-    return NULL; 
-  OSPLight light = ospNewLight3(typeString);
-  return Py_BuildValue("l", (uint64_t)light);
+  // we don't know the volume's voxel type, but at least make sure
+  // ospray won't read past the end of the buffer
+  const size_t numVoxels = size_t(std::max(0,size.x))*std::max(0,size.y)*std::max(0,size.z);
+  const size_t vs = numVoxels ? voxels.len/numVoxels : 0;
+  if (!PyBuffer_IsContiguous(&voxels,'C') || !numVoxels
+      || numVoxels*vs != (size_t)voxels.len || (vs != 1 && vs != 2 && vs != 4 && vs != 8)) {
+    PyBuffer_Release(&voxels);
+    PyErr_SetString(PyExc_ValueError,
+                    "ospSetRegion: voxels must be a C-contiguous buffer of exactly "
+                    "size.x*size.y*size.z voxels");
+    return NULL;
+  }
+  int ok;
+  Py_BEGIN_ALLOW_THREADS
+  ok = ospSetRegion(volume,voxels.buf,coords,size);
+  Py_END_ALLOW_THREADS
+  countBytes(voxels.len);
+  if (ok && sceneRecord(volume)) {
+    // ospray copied the voxels; so does the scene record
+    auto copy = std::make_shared<std::vector<unsigned char>>((const unsigned char *)voxels.buf,
+                                                             (const unsigned char *)voxels.buf+voxels.len);
+    recordRegion(volume,coords,size,SceneBlob(copy->data(),copy->size(),copy));
+  }
+  PyBuffer_Release(&voxels);
+  return PyBool_FromLong(ok);
 }
 
-
 // ------------------------------------------------------------------
-// ospNewFrameBuffer
+// ospLoadRawVolume(volume, fileName, dims, voxelType [, offset [, slabSlices]])
 // ------------------------------------------------------------------
-extern "C" PyObject *ospray_newFrameBuffer(PyObject *self, PyObject *args)
+extern "C" PyObject *ospray_loadRawVolume(PyObject *self, PyObject *args, PyObject *kwargs)
 {
-  osp::vec2i size;
-  const char *formatString;
-  PyObject   *channelsList;
-  
-  if (!PyArg_ParseTuple(args, "(ii)sO",
-                        &size.x, &size.y, &formatString, &channelsList)) 
-    return NULL;
+  static char *kwlist[] = {
+    (char*)"volume", (char*)"fileName", (char*)"dims", (char*)"voxelType",
+    (char*)"offset", (char*)"slabSlices", NULL
+  };
+  // arguments:
+  OSPVolume   volume;
+  const char *fileName;
+  osp::vec3i  dims;
+  const char *voxelType;
+  unsigned long long offset = 0;
+  int         slabSlices = 0;
 
-  OSPFrameBufferFormat format = parseFrameBufferFormat(formatString);
+  if (!PyArg_ParseTupleAndKeywords(args, kwargs, "O&s(iii)s|Ki", kwlist,
+                                   parseHandle, &volume, &fileName,
+                                   &dims.x, &dims.y, &dims.z, &voxelType,
+                                   &offset, &slabSlices)) 
+    return NULL;
 
-  std::vector<std::string> channelStrings = getStrings(channelsList);
-  uint64_t channels = 0;
-  for (auto &channel: channelStrings) {
-    if (channel == "color") channels |= OSP_FB_COLOR;
-    if (channel == "depth") channels |= OSP_FB_DEPTH;
-    if (channel == "accum") channels |= OSP_FB_ACCUM;
+  // a scene record references the voxels in the file, rather than
+  // keeping a copy
+  std::shared_ptr<MappedFile> mapped;
+  std::shared_ptr<SceneObject> record = sceneRecord(volume);
+  std::string error;
+  Py_BEGIN_ALLOW_THREADS
+  try {
+    loadRawVolume(volume,fileName,dims,voxelType,offset,slabSlices,
+                  record ? &mapped : nullptr);
+  } catch (const std::runtime_error &e) {
+    error = e.what();
   }
-  OSPFrameBuffer fb = ospNewFrameBuffer(size,format,channels);
-  return Py_BuildValue("l", (uint64_t)fb);
+  Py_END_ALLOW_THREADS
+  if (!error.empty()) {
+    PyErr_SetString(PyExc_IOError,("ospLoadRawVolume: "+error).c_str());
+    return NULL;
+  }
+  recordParam(volume,"voxelType",std::string(voxelType));
+  recordParam(volume,"dimensions",&dims.x,3);
+  const size_t numBytes = size_t(dims.x)*dims.y*dims.z*voxelSize(voxelType);
+  recordRegion(volume,{ 0, 0, 0 },dims,SceneBlob(mapped ? mapped->data+offset : nullptr,
+                                                 numBytes,mapped));
+  Py_INCREF(Py_None);
+  return Py_None;
 }
 
 
 
+// ==================================================================
+// scene snapshots
+// ==================================================================
+
 // ------------------------------------------------------------------
-// ospNewModel
+// ospRecordScene([enable])
 // ------------------------------------------------------------------
-extern "C" PyObject *ospray_newModel(PyObject *self, PyObject *args)
+/*! turns recording of the objects created from now on (their types,
+    parameters, data and model members) on or off, for ospSaveScene;
+    returns whether it was on. Turning it off forgets all records */
+extern "C" PyObject *ospray_recordScene(PyObject *self, PyObject *args)
 {
-  OSPModel model = ospNewModel();
-  return Py_BuildValue("l", (uint64_t)model);
+  int enable = 1;
+  if (!PyArg_ParseTuple(args, "|p", &enable)) 
+    return NULL;
+  const bool wasRecording = sceneRecording;
+  sceneRecording = enable;
+  if (!enable)
+    sceneObjects.clear();
+  return PyBool_FromLong(wasRecording);
 }
 
 // ------------------------------------------------------------------
-// ospNewGeometry
+// ospSaveScene(fileName, rootObjects)
 // ------------------------------------------------------------------
-extern "C" PyObject *ospray_newGeometry(PyObject *self, PyObject *args)
+/*! saves the root objects - and everything they use - to a scene
+    file, for ospLoadScene; returns its size in bytes. The objects
+    must have been created while ospRecordScene was on */
+extern "C" PyObject *ospray_saveScene(PyObject *self, PyObject *args)
 {
-  const char *typeString = nullptr;
-  if (!PyArg_ParseTuple(args, "s", &typeString)) 
-    return NULL; 
-  OSPGeometry geometry = ospNewGeometry(typeString);
-  return Py_BuildValue("l", (uint64_t)geometry);
-}
+  // arguments:
+  const char *fileName;
+  PyObject   *rootList;
+  if (!PyArg_ParseTuple(args, "sO", &fileName, &rootList)) 
+    return NULL;
+  PyObject *roots = PySequence_Fast(rootList,"ospSaveScene: rootObjects must be a sequence");
+  if (!roots)
+    return NULL;
+
+  SceneWriter writer;
+  std::vector<std::shared_ptr<SceneObject>> rootRecords;
+  try {
+    if (!sceneRecording)
+      throw std::runtime_error("scene recording is off (see ospRecordScene)");
+    for (Py_ssize_t i = 0; i < PySequence_Fast_GET_SIZE(roots); i++) {
+      OSPObject root;
+      if (!parseHandleArg(PySequence_Fast_GET_ITEM(roots,i),root)) {
+        Py_DECREF(roots);
+        return NULL;
+      }
+      auto record = sceneRecord(root);
+      if (!record)
+        throw std::runtime_error("root object #"+std::to_string(i)
+                                 +" was not created while recording");
+      writer.add(record);
+      rootRecords.push_back(record);
+    }
+  } catch (const std::runtime_error &e) {
+    Py_DECREF(roots);
+    PyErr_SetString(PyExc_ValueError,(std::string("ospSaveScene: ")+e.what()).c_str());
+    return NULL;
+  }
+  Py_DECREF(roots);
 
+  writer.put<uint64_t>(writer.order.size());
+  for (auto &object : writer.order)
+    writer.write(*object);
+  writer.putObjects(rootRecords);
+
+  // the records (and so the arrays) stay alive through 'writer'; the
+  // last of them may only go away with the GIL held, though (a data
+  // record may own a python buffer view)
+  uint64_t fileBytes = 0;
+  std::string error;
+  Py_BEGIN_ALLOW_THREADS
+  try {
+    fileBytes = writer.writeFile(fileName);
+  } catch (const std::runtime_error &e) {
+    error = e.what();
+  }
+  Py_END_ALLOW_THREADS
+  if (!error.empty()) {
+    PyErr_SetString(PyExc_IOError,("ospSaveScene: "+error).c_str());
+    return NULL;
+  }
+  return PyLong_FromUnsignedLongLong(fileBytes);
+}
 
 // ------------------------------------------------------------------
-// ospNewData
+// ospLoadScene(fileName)
 // ------------------------------------------------------------------
-extern "C" PyObject *ospray_newData(PyObject *self, PyObject *args)
+/*! re-creates the objects of a scene file; returns the root objects,
+    in the order they were saved. The file stays memory mapped, and
+    ospray uses its arrays in place, for as long as ospray may use any
+    object made from it */
+extern "C" PyObject *ospray_loadScene(PyObject *self, PyObject *args)
 {
-  // args:
-  int numItems;
-  const char *formatString;
-  PyObject   *valuesList;
-  
-  if (!PyArg_ParseTuple(args, "isO", &numItems, &formatString, &valuesList)) 
+  // arguments:
+  const char *fileName;
+  if (!PyArg_ParseTuple(args, "s", &fileName)) 
     return NULL;
 
-  const std::string format = formatString;
-  if (format == "float3a" || format == "OSP_FLOAT3A") {
-    std::vector<float> values = getFloats(valuesList);
-    OSPData data = ospNewData(numItems,OSP_FLOAT3A,values.data(),0);
-    return Py_BuildValue("l", (uint64_t)data);
+  std::shared_ptr<MappedFile> file;
+  std::vector<std::shared_ptr<SceneObject>> objects, roots;
+  std::vector<OSPObject> handles;
+  std::vector<size_t> rootIndices;
+  std::string error;
+  Py_BEGIN_ALLOW_THREADS
+  try {
+    SceneReader reader(fileName);
+    const uint64_t numObjects = reader.get<uint64_t>();
+    for (uint64_t i = 0; i < numObjects; i++)
+      reader.objects.push_back(reader.readObject());
+    const uint64_t numRoots = reader.get<uint64_t>();
+    for (uint64_t i = 0; i < numRoots; i++) {
+      const uint64_t index = reader.get<uint64_t>();
+      if (index >= numObjects || reader.objects[index]->kind == SceneObject::INSTANCES)
+        throw std::runtime_error("invalid root object in scene file");
+      rootIndices.push_back(index);
+    }
+    file    = reader.file;
+    objects = std::move(reader.objects);
+    handles = instantiateScene(objects);
+  } catch (const std::runtime_error &e) {
+    error = e.what();
+  }
+  Py_END_ALLOW_THREADS
+  if (!error.empty()) {
+    PyErr_SetString(PyExc_IOError,("ospLoadScene: "+error).c_str());
+    return NULL;
   }
-  if (format == "float4" || format == "OSP_FLOAT4") {
-    std::vector<float> values = getFloats(valuesList);
-    OSPData data = ospNewData(numItems,OSP_FLOAT4,values.data(),0);
-    return Py_BuildValue("l", (uint64_t)data);
+
+  static PyTypeObject *types[SceneObject::NUM_KINDS] = {
+    &CameraType, &RendererType, &LightType, &ModelType, &GeometryType, &DataType,
+    &VolumeType, &TransferFunctionType, &GeometryType, nullptr
+  };
+  // every object made from the file shares it (ospray uses its arrays
+  // in place, or objects that do), for as long as ospray may use the
+  // object; which gets tracked like for objects made one by one
+  std::unordered_map<const SceneObject*,OSPObject> handleOf;
+  for (size_t i = 0; i < objects.size(); i++)
+    handleOf[objects[i].get()] = handles[i];
+  for (size_t i = 0; i < objects.size(); i++) {
+    const SceneObject &object = *objects[i];
+    OSPObject handle = handles[i];
+    if (!handle) continue;
+    sceneFiles[handle] = file;
+    for (auto &param : object.params)
+      if (param.type == 'o')
+        dependencies.set(handle,param.name,handleOf[param.object.get()]);
+    for (auto &member : object.members)
+      if (member->kind == SceneObject::INSTANCES)
+        dependencies.add(handleOf[member->members[0].get()],handle);
+      else
+        dependencies.add(handleOf[member.get()],handle);
+    for (auto &element : object.elements)
+      dependencies.add(handleOf[element.get()],handle);
   }
-  if (format == "int3" || format == "OSP_INT3") {
-    std::vector<int> values = getInts(valuesList);
-    OSPData data = ospNewData(numItems,OSP_INT3,values.data(),0);
-    return Py_BuildValue("l", (uint64_t)data);
+
+  // the root objects keep the reference they got created with (a
+  // root saved more than once gets the same wrapper each time); the
+  // rest live on as long as something uses them
+  std::map<size_t,PyObject*> wrappers;
+  bool failed = false;
+  for (size_t index : rootIndices) {
+    if (failed || wrappers.count(index)) continue;
+    PyObject *wrapper = wrapObject(handles[index],types[objects[index]->kind]);
+    if (!wrapper) {
+      // wrapObject released it
+      handles[index] = nullptr;
+      failed = true;
+      continue;
+    }
+    wrappers[index] = wrapper;
+    if (sceneRecording)
+      sceneObjects[handles[index]] = objects[index];
   }
-  if (format == "light" || format == "OSP_LIGHT") {
-    std::vector<long> values = getLongs(valuesList);
-    OSPData data = ospNewData(numItems,OSP_LIGHT,values.data(),0);
-    return Py_BuildValue("l", (uint64_t)data);
+  for (size_t i = 0; i < handles.size(); i++)
+    if (handles[i] && !wrappers.count(i))
+      releaseObject(handles[i]);
+  if (failed) {
+    for (auto &wrapper : wrappers)
+      Py_DECREF(wrapper.second);
+    return NULL;
   }
 
-  throw std::runtime_error("unknown or not implemeneted format type '"
-                                  +format+"' is ospNewData");
-  
+  PyObject *result = PyList_New(rootIndices.size());
+  for (size_t i = 0; i < rootIndices.size(); i++) {
+    PyObject *wrapper = wrappers[rootIndices[i]];
+    Py_INCREF(wrapper);
+    PyList_SET_ITEM(result,i,wrapper);
+  }
+  for (auto &wrapper : wrappers)
+    Py_DECREF(wrapper.second);
+  drainReleases();
+  return result;
 }
 
 
 
+// ==================================================================
+// batched commands
+// ==================================================================
 
+/*! the objects a ospBatch command list can refer to: the handles
+    passed in by the caller, followed by every object the batch
+    created so far, in order */
+struct BatchObjects {
+  std::vector<OSPObject>      table;
+  /*! python type to wrap each created object in */
+  std::vector<PyTypeObject *> types;
+  size_t                      numPassedIn { 0 };
 
+  OSPObject get(PyObject *ref) const
+  {
+    const long index = getLong(ref);
+    if (index < 0 || (size_t)index >= table.size())
+      throw std::runtime_error("object reference #"+std::to_string(index)
+                               +" is out of range (have "
+                               +std::to_string(table.size())+" objects)");
+    if (!table[index])
+      throw std::runtime_error("object #"+std::to_string(index)+" was already released");
+    return table[index];
+  }
+  void add(OSPObject object, PyTypeObject *type = &ObjectType)
+  {
+    table.push_back(object);
+    types.push_back(type);
+  }
+  /*! an object the batch created: live, without a wrapper, until the
+      batch returns it */
+  void created(OSPObject object, PyTypeObject *type)
+  {
+    add(object,type);
+    if (object) liveObjects[object] = nullptr;
+  }
+};
 
+/*! execute one command of a ospBatch list; throws on error */
+void executeBatchCommand(BatchObjects &objects, PyObject *command)
+{
+  if (!PyTuple_Check(command) || PyTuple_GET_SIZE(command) < 1)
+    throw std::runtime_error("command is not a non-empty tuple");
+  const Py_ssize_t numArgs = PyTuple_GET_SIZE(command)-1;
+  const std::string op = getString(PyTuple_GET_ITEM(command,0));
+  auto arg = [&](int i) { return PyTuple_GET_ITEM(command,i+1); };
+  auto expectArgs = [&](Py_ssize_t n) {
+    if (numArgs != n)
+      throw std::runtime_error("'"+op+"' expects "+std::to_string(n)
+                               +" arguments, got "+std::to_string(numArgs));
+  };
 
-// ==================================================================
-// 'set' methods
-// ==================================================================
+  // object creation
+  auto create = [&](OSPObject object, PyTypeObject *type, SceneObject::Kind kind,
+                    const std::string &typeName) {
+    objects.created(object,type);
+    recordNew(object,kind,typeName);
+  };
+  if (op == "newCamera") {
+    expectArgs(1);
+    const std::string type = getString(arg(0));
+    create(ospNewCamera(type.c_str()),&CameraType,SceneObject::CAMERA,type);
+  } else if (op == "newRenderer") {
+    expectArgs(1);
+    const std::string type = getString(arg(0));
+    create(ospNewRenderer(type.c_str()),&RendererType,SceneObject::RENDERER,type);
+  } else if (op == "newLight") {
+    expectArgs(1);
+    const std::string type = getString(arg(0));
+    create(ospNewLight3(type.c_str()),&LightType,SceneObject::LIGHT,type);
+  } else if (op == "newGeometry") {
+    expectArgs(1);
+    const std::string type = getString(arg(0));
+    create(ospNewGeometry(type.c_str()),&GeometryType,SceneObject::GEOMETRY,type);
+  } else if (op == "newModel") {
+    expectArgs(0);
+    create(ospNewModel(),&ModelType,SceneObject::MODEL,"model");
+  }
+  else if (op == "newData") {
+    expectArgs(3);
+    objects.created(newData(getInt(arg(0)),getString(arg(1)),arg(2)),&DataType);
+  }
+  // parameters
+  else if (op == "set1i") {
+    expectArgs(3);
+    const int value = getInt(arg(2));
+    ospSet1i(objects.get(arg(0)),getString(arg(1)).c_str(),value);
+    recordParam(objects.get(arg(0)),getString(arg(1)).c_str(),&value,1);
+  } else if (op == "set1f") {
+    expectArgs(3);
+    const float value = getFloat(arg(2));
+    ospSet1f(objects.get(arg(0)),getString(arg(1)).c_str(),value);
+    recordParam(objects.get(arg(0)),getString(arg(1)).c_str(),&value,1);
+  } else if (op == "set3fv") {
+    expectArgs(3);
+    float value[3];
+    getFloats(arg(2),value,3);
+    ospSet3fv(objects.get(arg(0)),getString(arg(1)).c_str(),value);
+    recordParam(objects.get(arg(0)),getString(arg(1)).c_str(),value,3);
+  } else if (op == "setObject") {
+    expectArgs(3);
+    ospSetObject(objects.get(arg(0)),getString(arg(1)).c_str(),objects.get(arg(2)));
+    dependencies.set(objects.get(arg(0)),getString(arg(1)),objects.get(arg(2)));
+    recordObjectParam(objects.get(arg(0)),getString(arg(1)).c_str(),objects.get(arg(2)));
+  } else if (op == "setData") {
+    expectArgs(3);
+    ospSetData(objects.get(arg(0)),getString(arg(1)).c_str(),(OSPData)objects.get(arg(2)));
+    dependencies.set(objects.get(arg(0)),getString(arg(1)),objects.get(arg(2)));
+    recordObjectParam(objects.get(arg(0)),getString(arg(1)).c_str(),objects.get(arg(2)));
+  }
+  // misc
+  else if (op == "addGeometry") {
+    expectArgs(2);
+    ospAddGeometry((OSPModel)objects.get(arg(0)),(OSPGeometry)objects.get(arg(1)));
+    dependencies.add(objects.get(arg(1)),objects.get(arg(0)));
+    recordMember(objects.get(arg(0)),objects.get(arg(1)));
+  } else if (op == "commit") {
+    expectArgs(1);
+    ospCommit(objects.get(arg(0)));
+    recordCommit(objects.get(arg(0)));
+  } else if (op == "release") {
+    expectArgs(1);
+    const long index = getLong(arg(0));
+    releaseObject(objects.get(arg(0)));
+    objects.table[index] = nullptr;
+  } else
+    throw std::runtime_error("unknown command '"+op+"'");
+}
 
 // ------------------------------------------------------------------
-// ospSetObject(OSPObject)
+// ospBatch(commands [, objects])
 // ------------------------------------------------------------------
-extern "C" PyObject *ospray_setObject(PyObject *self, PyObject *args)
+extern "C" PyObject *ospray_batch(PyObject *self, PyObject *args)
 {
   // arguments:
-  OSPObject object;
-  const char *varName;
-  OSPObject value;
-  
-  if (!PyArg_ParseTuple(args, "lsl", &object,&varName,&value)) 
+  PyObject *commandList;
+  PyObject *objectList = NULL;
+
+  if (!PyArg_ParseTuple(args, "O|O", &commandList, &objectList)) 
     return NULL;
 
-  ospSetObject(object,varName,value);
-  Py_INCREF(Py_None);
-  return Py_None;
+  PyObject *commands = PySequence_Fast(commandList,"ospBatch: commands must be a sequence");
+  if (!commands)
+    return NULL;
+
+  BatchObjects objects;
+  Py_ssize_t current = -1;
+  try {
+    if (objectList) {
+      std::vector<OSPObject> handles = getHandles(objectList);
+      for (auto handle : handles)
+        objects.add(handle);
+      objects.numPassedIn = handles.size();
+    }
+    const Py_ssize_t numCommands = PySequence_Fast_GET_SIZE(commands);
+    for (current=0;current<numCommands;current++)
+      executeBatchCommand(objects,PySequence_Fast_GET_ITEM(commands,current));
+  } catch (const std::runtime_error &e) {
+    // don't leak what we created so far; anything that references
+    // these objects keeps them alive through ospray's refcounting
+    for (size_t i=objects.numPassedIn;i<objects.table.size();i++)
+      if (objects.table[i]) releaseObject(objects.table[i]);
+    Py_DECREF(commands);
+    PyErr_SetString(PyExc_ValueError,
+                    ("ospBatch: command #"+std::to_string(current)+": "+e.what()).c_str());
+    return NULL;
+  }
+  Py_DECREF(commands);
+
+  // return all objects the batch created (None for the ones it also
+  // released again)
+  drainReleases();
+  PyObject *created = PyList_New(objects.table.size()-objects.numPassedIn);
+  for (size_t i=objects.numPassedIn;i<objects.table.size();i++) {
+    PyObject *wrapper = Py_None;
+    if (objects.table[i])
+      wrapper = wrapObject(objects.table[i],objects.types[i]);
+    else
+      Py_INCREF(wrapper);
+    if (!wrapper) {
+      // wrapObject released that object; the remaining ones go with
+      // the list
+      for (size_t j=i+1;j<objects.table.size();j++)
+        if (objects.table[j]) releaseObject(objects.table[j]);
+      Py_DECREF(created);
+      return NULL;
+    }
+    PyList_SET_ITEM(created,i-objects.numPassedIn,wrapper);
+  }
+  return created;
 }
 
+
+
+
+
+// ==================================================================
+// instrumentation
+// ==================================================================
+
 // ------------------------------------------------------------------
-// ospSetData(OSPData)
+// enable_stats(enabled=True, trace=False)
 // ------------------------------------------------------------------
-extern "C" PyObject *ospray_setData(PyObject *self, PyObject *args)
+extern "C" PyObject *ospray_enableStats(PyObject *self, PyObject *args)
 {
-  // arguments:
-  OSPObject object;
-  const char *varName;
-  OSPData value;
-  
-  if (!PyArg_ParseTuple(args, "lsl", &object,&varName,&value)) 
+  int enabled = 1, trace = 0;
+  if (!PyArg_ParseTuple(args, "|ii", &enabled, &trace)) 
     return NULL;
-
-  ospSetData(object,varName,value);
+  statsEnabled = enabled != 0;
+  traceEnabled = enabled && trace;
   Py_INCREF(Py_None);
   return Py_None;
 }
 
+/*! stats of all instrumented functions, in method table order */
+static std::vector<FunctionStats *> allFunctionStats;
+
 // ------------------------------------------------------------------
-// ospSet1i(int)
+// stats()
 // ------------------------------------------------------------------
-extern "C" PyObject *ospray_set1i(PyObject *self, PyObject *args)
+extern "C" PyObject *ospray_stats(PyObject *self, PyObject *args)
 {
-  // arguments:
-  OSPObject object;
-  const char *varName;
-  int value;
-  
-  if (!PyArg_ParseTuple(args, "lsi", &object,&varName,&value)) 
-    return NULL;
-
-  ospSet1i(object,varName,value);
-  Py_INCREF(Py_None);
-  return Py_None;
+  PyObject *dict = PyDict_New();
+  for (auto stats : allFunctionStats) {
+    if (!stats->numCalls) continue;
+    PyObject *entry
+      = Py_BuildValue("{s:K,s:d,s:d,s:K}",
+                      "calls",      (unsigned long long)stats->numCalls,
+                      "total_time", stats->totalNs*1e-9,
+                      "max_time",   stats->maxNs*1e-9,
+                      "bytes",      (unsigned long long)stats->numBytes);
+    if (!entry || PyDict_SetItemString(dict,stats->name,entry) < 0) {
+      Py_XDECREF(entry);
+      Py_DECREF(dict);
+      return NULL;
+    }
+    Py_DECREF(entry);
+  }
+  return dict;
 }
 
 // ------------------------------------------------------------------
-// ospSet1f(float)
+// reset_stats()
 // ------------------------------------------------------------------
-extern "C" PyObject *ospray_set1f(PyObject *self, PyObject *args)
+extern "C" PyObject *ospray_resetStats(PyObject *self, PyObject *args)
 {
-  // arguments:
-  OSPObject object;
-  const char *varName;
-  float value;
-  
-  if (!PyArg_ParseTuple(args, "lsf", &object,&varName,&value)) 
-    return NULL;
-
-  ospSet1f(object,varName,value);
+  for (auto stats : allFunctionStats)
+    stats->reset();
+  {
+    std::lock_guard<std::mutex> lock(traceMutex);
+    traceEvents.clear();
+  }
   Py_INCREF(Py_None);
   return Py_None;
 }
 
 // ------------------------------------------------------------------
-// ospSet3fv(list of three floats)
+// dump_trace(fileName)
 // ------------------------------------------------------------------
-extern "C" PyObject *ospray_set3fv(PyObject *self, PyObject *args)
+extern "C" PyObject *ospray_dumpTrace(PyObject *self, PyObject *args)
 {
-  // arguments:
-  OSPObject object;
-  const char *varName;
-  PyObject *valuesList;
-  
-  if (!PyArg_ParseTuple(args, "lsO", &object,&varName,&valuesList)) 
+  const char *fileName;
+  if (!PyArg_ParseTuple(args, "s", &fileName)) 
     return NULL;
 
-  std::vector<float> value = getFloats(valuesList);
-  assert(value.size() == 3);
-  ospSet3fv(object,varName,value.data());
+  std::vector<TraceEvent> events;
+  {
+    std::lock_guard<std::mutex> lock(traceMutex);
+    events = traceEvents;
+  }
+  FILE *file = fopen(fileName, "w");
+  if (!file) {
+    PyErr_SetFromErrnoWithFilename(PyExc_OSError, (char*)fileName);
+    return NULL;
+  }
+  Py_BEGIN_ALLOW_THREADS
+  fprintf(file, "{\"traceEvents\":[\n");
+  for (size_t i = 0; i < events.size(); i++)
+    fprintf(file, "{\"name\":\"%s\",\"ph\":\"X\",\"pid\":0,\"tid\":%zu,"
+            "\"ts\":%.3f,\"dur\":%.3f}%s\n",
+            events[i].name, events[i].thread % 1000000,
+            events[i].beginNs*1e-3, events[i].durationNs*1e-3,
+            i+1 < events.size() ? "," : "");
+  fprintf(file, "]}\n");
+  fclose(file);
+  Py_END_ALLOW_THREADS
   Py_INCREF(Py_None);
   return Py_None;
 }
 
+/*! the python-side object behind each instrumented module function:
+    it's passed as 'self' to the trampoline, and holds the actual
+    implementation, its stats, and the method def the python function
+    object refers to */
+struct InstrumentedFunction {
+  PyObject_HEAD
+  PyMethodDef   def;
+  PyCFunction   impl;
+  FunctionStats stats;
+};
 
+static PyTypeObject InstrumentedFunctionType = { PyVarObject_HEAD_INIT(NULL, 0) };
 
+static PyObject *instrumentedCall(PyObject *self, PyObject *args)
+{
+  InstrumentedFunction *f = (InstrumentedFunction *)self;
+  if (!statsEnabled)
+    return f->impl(NULL,args);
+  CallScope scope(&f->stats);
+  return f->impl(NULL,args);
+}
 
+static PyObject *instrumentedCallWithKeywords(PyObject *self, PyObject *args, PyObject *kwargs)
+{
+  InstrumentedFunction *f = (InstrumentedFunction *)self;
+  if (!statsEnabled)
+    return ((PyCFunctionWithKeywords)f->impl)(NULL,args,kwargs);
+  CallScope scope(&f->stats);
+  return ((PyCFunctionWithKeywords)f->impl)(NULL,args,kwargs);
+}
 
+static PyObject *instrumentedFastCall(PyObject *self, PyObject *const *args, Py_ssize_t nargs)
+{
+  typedef PyObject *(*FastFunction)(PyObject *, PyObject *const *, Py_ssize_t);
+  InstrumentedFunction *f = (InstrumentedFunction *)self;
+  if (!statsEnabled)
+    return ((FastFunction)f->impl)(NULL,args,nargs);
+  CallScope scope(&f->stats);
+  return ((FastFunction)f->impl)(NULL,args,nargs);
+}
 
+/*! the trampolines of all instrumented functions; created along with
+    the first module object, and shared (stats included) by all later
+    ones. Never released */
+static std::vector<InstrumentedFunction *> instrumentedFunctions;
 
-
-
-
+/*! add all functions of given method table to the module, each
+    wrapped in an instrumentation trampoline */
+int addInstrumentedFunctions(PyObject *module, PyMethodDef *methods)
+{
+  if (instrumentedFunctions.empty()) {
+    InstrumentedFunctionType.tp_name      = "ospray.InstrumentedFunction";
+    InstrumentedFunctionType.tp_basicsize = sizeof(InstrumentedFunction);
+    InstrumentedFunctionType.tp_flags     = Py_TPFLAGS_DEFAULT;
+    if (PyType_Ready(&InstrumentedFunctionType) < 0)
+      return -1;
+    for (PyMethodDef *m = methods; m->ml_name; m++) {
+      InstrumentedFunction *f
+        = PyObject_New(InstrumentedFunction,&InstrumentedFunctionType);
+      if (!f) return -1;
+      new (&f->stats) FunctionStats;
+      f->stats.name = m->ml_name;
+      f->impl       = m->ml_meth;
+      f->def        = *m;
+      f->def.ml_meth = (m->ml_flags & METH_KEYWORDS)
+        ? (PyCFunction)instrumentedCallWithKeywords
+        : (m->ml_flags & METH_FASTCALL)
+        ? (PyCFunction)instrumentedFastCall
+        : instrumentedCall;
+      instrumentedFunctions.push_back(f);
+      allFunctionStats.push_back(&f->stats);
+    }
+  }
+  PyObject *moduleName = PyObject_GetAttrString(module,"__name__");
+  for (auto f : instrumentedFunctions) {
+    PyObject *function = PyCFunction_NewEx(&f->def,(PyObject*)f,moduleName);
+    if (!function || PyModule_AddObject(module,f->def.ml_name,function) < 0) {
+      Py_XDECREF(function);
+      Py_XDECREF(moduleName);
+      return -1;
+    }
+  }
+  Py_XDECREF(moduleName);
+  return 0;
+}
 
 
 
@@ -607,49 +6819,169 @@ static PyMethodDef SpamMethods[] = {
   //misc
   {"ospInit",       ospray_init,       METH_VARARGS, "initialize ospray library."},
   {"ospShutdown",       ospray_shutdown,       METH_VARARGS, "shutdownialize ospray library."},
-  {"ospCommit",     ospray_commit,     METH_VARARGS, "ospCommit()."},
+  {"ospCommit",     (PyCFunction)ospray_commit,     METH_FASTCALL, "ospCommit()."},
   {"ospAddGeometry",ospray_addGeometry,METH_VARARGS, "ospAddGeometry."},
+  {"ospAddVolume",  ospray_addVolume,  METH_VARARGS, "ospAddVolume."},
   {"ospRelease",    ospray_release,    METH_VARARGS, "release object handle"},
   {"ospFrameBufferClear",ospray_frameBufferClear,   METH_VARARGS, "clear specified channels of a frame buffer."},
-  {"ospFrameBufferSave",ospray_frameBufferSave,   METH_VARARGS, "save frame buffer in a file."},
-  {"ospRenderFrame",ospray_renderFrame,   METH_VARARGS, "clear specified channels of a frame buffer."},
+  {"ospFrameBufferSave",(PyCFunction)ospray_frameBufferSave,   METH_VARARGS|METH_KEYWORDS, "save frame buffer in a .png/.ppm/.pfm/.exr file (optional: compressionLevel for png, channel='color'|'depth')."},
+  {"ospSaveImage",(PyCFunction)ospray_saveImage,   METH_VARARGS|METH_KEYWORDS, "save (height, width, 4) pixels from any buffer in a .png/.ppm/.pfm/.exr file (format='srgba'|'rgba8'|'rgba32f'|'depth')."},
+  {"ospRenderFrame",(PyCFunction)ospray_renderFrame,   METH_FASTCALL, "render a frame; returns ospray's variance estimate."},
+  {"ospRenderProgressive",ospray_renderProgressive,   METH_VARARGS, "accumulate frames until converged, out of time, or maxFrames; returns (frames, variance)."},
+  {"ospRenderViews",(PyCFunction)ospray_renderViews,METH_VARARGS|METH_KEYWORDS, "render one frame per camera view (N,9: pos, dir, up) into one (N,H,W,4) buffer."},
+  {"ospRenderFrameAsync",ospray_renderFrameAsync,   METH_VARARGS, "render a frame on a native worker thread; returns a RenderFuture."},
+  {"ospFrameBufferSaveAsync",(PyCFunction)ospray_frameBufferSaveAsync,   METH_VARARGS|METH_KEYWORDS, "copy frame buffer and save it in a file in the background."},
+  {"ospFlushSaves",ospray_flushSaves,   METH_VARARGS, "wait until all background saves are written."},
+  {"ospSetSaveQueue",ospray_setSaveQueue,   METH_VARARGS, "set number of background save threads and max frames in flight."},
+  {"ospMapFrameBuffer",ospray_mapFrameBuffer,   METH_VARARGS, "map a frame buffer channel ('color' or 'depth') as read-only buffer object."},
+  {"ospUnmapFrameBuffer",ospray_unmapFrameBuffer,   METH_VARARGS, "unmap a frame buffer channel mapped with ospMapFrameBuffer."},
+  {"ospNewFrameRing",(PyCFunction)ospray_newFrameRing,METH_VARARGS|METH_KEYWORDS, "create a shared-memory ring buffer of frames for other processes (optional: format, slots)."},
+  {"ospSetFrameSink",ospray_setFrameSink,METH_VARARGS, "publish every frame rendered into a frame buffer to a frame ring (None: stop)."},
+  {"ospPublishFrame",ospray_publishFrame,METH_VARARGS, "publish a frame buffer's color channel to a frame ring; returns the frame id."},
   //object creation
   {"ospNewCamera",  ospray_newCamera,  METH_VARARGS, "create a new camera object."},
   {"ospNewRenderer",ospray_newRenderer,METH_VARARGS, "create a new renderer object."},
   {"ospNewLight",   ospray_newLight,   METH_VARARGS, "create a new light object."},
   {"ospNewModel",   ospray_newModel,   METH_VARARGS, "create a new model object."},
   {"ospNewFrameBuffer",ospray_newFrameBuffer,   METH_VARARGS, "create a new frame buffer object."},
-  {"ospNewData",    ospray_newData,    METH_VARARGS, "create a new data object."},
+  {"ospNewData",    (PyCFunction)ospray_newData,    METH_VARARGS|METH_KEYWORDS, "create a new data object (optional: flags, and byte stride/offset for interleaved buffers)."},
+  {"ospDataCache",  ospray_dataCache,  METH_VARARGS, "enable the content-addressed ospNewData cache with given memory cap in bytes (0 disables it)."},
+  {"ospDataCacheClear",ospray_dataCacheClear,METH_NOARGS, "evict everything from the ospNewData cache."},
+  {"ospDataCacheStats",ospray_dataCacheStats,METH_NOARGS, "ospNewData cache counters, as a dict."},
+  {"ospUpdateData", (PyCFunction)ospray_updateData, METH_VARARGS|METH_KEYWORDS, "write items of a shared-memory data object in place (optional: offset, values, commit), and commit what uses it."},
+  {"ospUpdateDataRanges",(PyCFunction)ospray_updateDataRanges,METH_VARARGS|METH_KEYWORDS, "copy dirty (first, count) item ranges into a shared-memory data object, and commit what uses it."},
   {"ospNewGeometry",ospray_newGeometry,METH_VARARGS, "create a new geometry object."},
+  {"ospNewVolume",  ospray_newVolume,  METH_VARARGS, "create a new volume object."},
+  {"ospNewTransferFunction",ospray_newTransferFunction,METH_VARARGS, "create a new transfer function object."},
+  {"ospLoadMesh",   ospray_loadMesh,   METH_VARARGS, "load an OBJ or PLY file into a committed triangles geometry."},
+  {"ospAddInstances",ospray_addInstances,METH_VARARGS, "add one instance of a prototype model per transform ((N,12) or (N,4,4) buffer) to a model."},
+  {"ospNewInstance",(PyCFunction)ospray_newInstance,METH_FASTCALL, "create an instance of a model with given affine transform (12 floats)."},
   //set functions
-  {"ospSetData",    ospray_setData,  METH_VARARGS, "set data-object parameter."},
-  {"ospSetObject",  ospray_setObject,METH_VARARGS, "set object-object parameter."},
-  {"ospSetf",       ospray_set1f,    METH_VARARGS, "set 1f-typed parameter."},
-  {"ospSet1i",      ospray_set1i,    METH_VARARGS, "set 1i-typed parameter."},
-  {"ospSet1f",      ospray_set1f,    METH_VARARGS, "set 1f-typed parameter."},
-  {"ospSet3fv",     ospray_set3fv,   METH_VARARGS, "set param to list of three floats."},
+  {"ospSetData",    (PyCFunction)ospray_setData,  METH_FASTCALL, "set data-object parameter."},
+  {"ospSetObject",  (PyCFunction)ospray_setObject,METH_FASTCALL, "set object-object parameter."},
+  {"ospSetf",       (PyCFunction)ospray_set1f,    METH_FASTCALL, "set 1f-typed parameter."},
+  {"ospSet1i",      (PyCFunction)ospray_set1i,    METH_FASTCALL, "set 1i-typed parameter."},
+  {"ospSet1f",      (PyCFunction)ospray_set1f,    METH_FASTCALL, "set 1f-typed parameter."},
+  {"ospSeti",       (PyCFunction)ospray_set1i,    METH_FASTCALL, "set 1i-typed parameter."},
+  {"ospSet1b",      (PyCFunction)ospray_set1b,    METH_FASTCALL, "set bool parameter."},
+  {"ospSetString",  (PyCFunction)ospray_setString,METH_FASTCALL, "set string parameter."},
+  {"ospSetVoidPtr", (PyCFunction)ospray_setVoidPtr,METH_FASTCALL, "set raw pointer (given as int) parameter."},
+  {"ospSet2f",      (PyCFunction)ospray_set2f,    METH_FASTCALL, "set param to two floats."},
+  {"ospSet3f",      (PyCFunction)ospray_set3f,    METH_FASTCALL, "set param to three floats."},
+  {"ospSet4f",      (PyCFunction)ospray_set4f,    METH_FASTCALL, "set param to four floats."},
+  {"ospSet2fv",     (PyCFunction)ospray_set2fv,   METH_FASTCALL, "set param to list of two floats."},
+  {"ospSet3fv",     (PyCFunction)ospray_set3fv,   METH_FASTCALL, "set param to list of three floats."},
+  {"ospSet4fv",     (PyCFunction)ospray_set4fv,   METH_FASTCALL, "set param to list of four floats."},
+  {"ospSetVec2f",   (PyCFunction)ospray_set2fv,   METH_FASTCALL, "set param to list of two floats."},
+  {"ospSetVec3f",   (PyCFunction)ospray_set3fv,   METH_FASTCALL, "set param to list of three floats."},
+  {"ospSetVec4f",   (PyCFunction)ospray_set4fv,   METH_FASTCALL, "set param to list of four floats."},
+  {"ospSet2i",      (PyCFunction)ospray_set2i,    METH_FASTCALL, "set param to two ints."},
+  {"ospSet3i",      (PyCFunction)ospray_set3i,    METH_FASTCALL, "set param to three ints."},
+  {"ospSet4i",      (PyCFunction)ospray_set4i,    METH_FASTCALL, "set param to four ints."},
+  {"ospSet2iv",     (PyCFunction)ospray_set2iv,   METH_FASTCALL, "set param to list of two ints."},
+  {"ospSet3iv",     (PyCFunction)ospray_set3iv,   METH_FASTCALL, "set param to list of three ints."},
+  {"ospSet4iv",     (PyCFunction)ospray_set4iv,   METH_FASTCALL, "set param to list of four ints."},
+  {"ospSetVec2i",   (PyCFunction)ospray_set2iv,   METH_FASTCALL, "set param to list of two ints."},
+  {"ospSetVec3i",   (PyCFunction)ospray_set3iv,   METH_FASTCALL, "set param to list of three ints."},
+  //volumes
+  {"ospSetRegion",  ospray_setRegion,METH_VARARGS, "copy a region of voxels (buffer object) into a volume."},
+  {"ospLoadRawVolume",(PyCFunction)ospray_loadRawVolume,METH_VARARGS|METH_KEYWORDS, "load a raw voxel file into a volume, memory mapped and slab by slab."},
+  //scene snapshots
+  {"ospRecordScene", ospray_recordScene, METH_VARARGS, "turn recording of new objects (for ospSaveScene) on or off; returns the previous state."},
+  {"ospSaveScene",  ospray_saveScene, METH_VARARGS, "save root objects and everything they use to a binary scene file."},
+  {"ospLoadScene",  ospray_loadScene, METH_VARARGS, "re-create the objects of a scene file, sharing its memory-mapped arrays; returns the roots."},
+  //batched commands
+  {"ospBatch",      ospray_batch,    METH_VARARGS, "execute a list of commands in one call; returns handles of created objects."},
   //...
   {NULL, NULL, 0, NULL}        /* Sentinel */
 };
 
-PyMODINIT_FUNC
-initospray(void)
+/*! functions to query the instrumentation (which aren't instrumented
+    themselves) */
+static PyMethodDef StatsMethods[] = {
+  {"enable_stats",  ospray_enableStats, METH_VARARGS, "enable_stats(enabled=True, trace=False): turn per-call stats (and tracing) on or off."},
+  {"stats",         ospray_stats,       METH_VARARGS, "per-function calls, total/max time (s), and bytes converted/copied."},
+  {"reset_stats",   ospray_resetStats,  METH_VARARGS, "reset all per-function stats and the trace."},
+  {"dump_trace",    ospray_dumpTrace,   METH_VARARGS, "write recorded calls as chrome://tracing json file."},
+  {NULL, NULL, 0, NULL}        /* Sentinel */
+};
+
+/*! populates a new module object; with multi-phase init python
+    calls this once per module object it creates (e.g., once per
+    sub-interpreter), but the static types and interned names only
+    get set up for the first one */
+static int execModule(PyObject *module)
 {
   printf("#PySPRay: Initializing pyton-ospray module...\n");
-  
-  (void) Py_InitModule("ospray", SpamMethods);
+
+  static bool typesReady = false;
+  if (!typesReady) {
+    if (initChannelNames() < 0
+        || initMappedFrameBufferType() < 0
+        || initRenderFutureType() < 0
+        || initFrameRingType() < 0)
+      return -1;
+    typesReady = true;
+  }
+  if (addInstrumentedFunctions(module, SpamMethods) < 0
+      || initObjectTypes(module) < 0)
+    return -1;
+  if (PyModule_AddIntConstant(module, "OSP_DATA_SHARED_BUFFER", OSP_DATA_SHARED_BUFFER) < 0)
+    return -1;
+  const char *statsEnv = getenv("PYOSPRAY_STATS");
+  if (statsEnv && atoi(statsEnv) > 0)
+    statsEnabled = true;
+  Py_INCREF(&MappedFrameBufferType);
+  if (PyModule_AddObject(module, "MappedFrameBuffer", (PyObject*)&MappedFrameBufferType) < 0) {
+    Py_DECREF(&MappedFrameBufferType);
+    return -1;
+  }
+  Py_INCREF(&RenderFutureType);
+  if (PyModule_AddObject(module, "RenderFuture", (PyObject*)&RenderFutureType) < 0) {
+    Py_DECREF(&RenderFutureType);
+    return -1;
+  }
+  Py_INCREF(&FrameRingType);
+  if (PyModule_AddObject(module, "FrameRing", (PyObject*)&FrameRingType) < 0) {
+    Py_DECREF(&FrameRingType);
+    return -1;
+  }
+  return 0;
+}
+
+static PyModuleDef_Slot moduleSlots[] = {
+  {Py_mod_exec, (void*)execModule},
+  {0, NULL}
+};
+
+static PyModuleDef moduleDef = {
+  PyModuleDef_HEAD_INIT,
+  "ospray",                           /* m_name */
+  "python bindings for the OSPRay API.", /* m_doc */
+  0,                                  /* m_size */
+  StatsMethods,                       /* m_methods */
+  moduleSlots,                        /* m_slots */
+  NULL, NULL, NULL                    /* m_traverse, m_clear, m_free */
+};
+
+PyMODINIT_FUNC
+PyInit_ospray(void)
+{
+  return PyModuleDef_Init(&moduleDef);
 }
 
 // iw - the tutorial suggests doing this function, but i'm not even
 // sure it ever gets called!?
 int main(int argc, char *argv[])
 {
-  /* Pass argv[0] to the Python interpreter */
-  Py_SetProgramName(argv[0]);
+  /* Add a static module; must happen before Py_Initialize */
+  PyImport_AppendInittab("ospray", PyInit_ospray);
   
   /* Initialize the Python interpreter.  Required. */
   Py_Initialize();
   
-  /* Add a static module */
-  initospray();
+  PyObject *module = PyImport_ImportModule("ospray");
+  Py_XDECREF(module);
+  Py_Finalize();
+  return 0;
 }
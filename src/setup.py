@@ -1,20 +1,39 @@
-from distutils.core import setup, Extension
+import os
+import sys
+from setuptools import setup, Extension
+from setuptools.command.build_ext import build_ext
+
+# ospray install prefix; override with OSPRAY_DIR=/path/to/ospray
+ospray_dir = os.environ.get('OSPRAY_DIR', '/usr/local')
 
 ospraymodule = Extension('ospray',
                     define_macros = [('MAJOR_VERSION', '1'),
                                      ('MINOR_VERSION', '0')],
-                    include_dirs = ['/usr/local/include'],
-                    libraries = ['ospray'],
-                    library_dirs = ['/usr/local/lib'],
+                    include_dirs = [os.path.join(ospray_dir, 'include')],
+                    # shm_open lives in librt on older linux
+                    libraries = ['ospray', 'z'] + (['rt'] if sys.platform.startswith('linux') else []),
+                    library_dirs = [os.path.join(ospray_dir, 'lib')],
+                    language = 'c++',
                     sources = ['PythonBindings.cpp'])
 
+class BuildExt(build_ext):
+    """build_ext that asks gcc and clang for c++11; msvc doesn't know
+    the flag (and its default standard is newer anyway)"""
+    def build_extensions(self):
+        if self.compiler.compiler_type != 'msvc':
+            for ext in self.extensions:
+                ext.extra_compile_args.append('-std=c++11')
+        build_ext.build_extensions(self)
+
 setup (name = 'ospray',
        version = '1.0',
-       description = 'This is a demo package',
+       description = 'Python bindings for the OSPRay API',
        author = 'Ingo Wald',
        author_email = 'ingowald@gmail.com',
-       url = 'https://docs.python.org/extending/building',
+       url = 'https://github.com/ingowald/python-ospray',
        long_description = '''
-This is really just a demo package.
+Python bindings for the OSPRay ray tracing API.
 ''',
-       ext_modules = [ospraymodule])
+       python_requires = '>=3.7',
+       ext_modules = [ospraymodule],
+       cmdclass = {'build_ext': BuildExt})